@@ -0,0 +1,82 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.h"
+
+#ifdef COUNT_ALLOCATIONS
+
+namespace
+{
+	thread_local size_t allocations = 0;
+}
+
+// every other form of the default operator new and delete calls these
+void* operator new(std::size_t size)
+{
+	++allocations;
+	if (size == 0)
+		size = 1;
+	while (true)
+	{
+		void* p = std::malloc(size);
+		if (p != nullptr)
+			return p;
+		std::new_handler handler = std::get_new_handler();
+		if (handler == nullptr)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+bool AllocationCounter::enabled()
+{
+	return true;
+}
+
+size_t AllocationCounter::count()
+{
+	return allocations;
+}
+
+#else
+
+bool AllocationCounter::enabled()
+{
+	return false;
+}
+
+size_t AllocationCounter::count()
+{
+	return 0;
+}
+
+#endif
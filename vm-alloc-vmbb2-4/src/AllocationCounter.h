@@ -17,18 +17,17 @@ You should have received a copy of the GNU General Public License
 along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
 */
 
-#ifndef CHANGE_H
-#define CHANGE_H
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
 
-#include <vector>
+#include <cstddef>
 
-#include "VM.h"
-
-struct Change
+// counts the heap allocations (operator new calls) of the current thread
+// the counting replacement of the global operator new is only compiled in on request (-DCOUNT_ALLOCATIONS)
+namespace AllocationCounter
 {
-	VM* VMAllocated;
-	PM* targetPM;
-	std::vector<VM*> doNotFitAnymore; // list of VMs that do not fit onto the target PM anymore
-};
+	bool enabled();
+	size_t count(); // always 0 if not enabled
+}
 
-#endif
\ No newline at end of file
+#endif
@@ -34,7 +34,8 @@ struct AllocatorParams
 {
 	AllocatorType allocatorType;
 	std::string name;
-	double timeout; // timeout in seconds
+	double timeout; // timeout in seconds (wall-clock time)
+	double CPUTimeout; // limit of the CPU time of all threads in seconds, 0 for no limit
 	int maxMigrationsRatio;
 
 	// force class to be polymorphic
@@ -0,0 +1,122 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BITSET_H
+#define BITSET_H
+
+#include <vector>
+#include <cstdint>
+#include <cassert>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// index of the lowest set bit, the word must not be zero
+inline int lowestBit(uint64_t word)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return (int)index;
+#else
+	return __builtin_ctzll(word);
+#endif
+}
+
+// number of set bits
+inline int popCount(uint64_t word)
+{
+#ifdef _MSC_VER
+	return (int)__popcnt64(word);
+#else
+	return __builtin_popcountll(word);
+#endif
+}
+
+// dense set of small non-negative integers (e.g. PM IDs), stored in 64 bit words
+// the number of elements is maintained, so count() is O(1); bulk operations recount with popcount
+class Bitset
+{
+	std::vector<uint64_t> m_words;
+	int m_size; // number of possible elements
+	int m_count; // number of elements in the set
+
+	static int wordIndex(int i) { return i >> 6; }
+	static uint64_t bitMask(int i) { return uint64_t(1) << (i & 63); }
+
+public:
+	Bitset() :m_size(0), m_count(0) {}
+	explicit Bitset(int size) :m_words((size + 63) / 64, 0), m_size(size), m_count(0) {}
+
+	int size() const { return m_size; }
+	int count() const { return m_count; }
+	bool empty() const { return m_count == 0; }
+
+	bool test(int i) const
+	{
+		assert(i >= 0 && i < m_size);
+		return (m_words[wordIndex(i)] & bitMask(i)) != 0;
+	}
+
+	void set(int i)
+	{
+		assert(!test(i));
+		m_words[wordIndex(i)] |= bitMask(i);
+		++m_count;
+	}
+
+	void reset(int i)
+	{
+		assert(test(i));
+		m_words[wordIndex(i)] &= ~bitMask(i);
+		--m_count;
+	}
+
+	// returns the smallest element not less than i, or size() if there is none
+	int next(int i) const
+	{
+		if (i >= m_size)
+			return m_size;
+		int w = wordIndex(i);
+		uint64_t word = m_words[w] & (~uint64_t(0) << (i & 63));
+		while (word == 0)
+		{
+			if (++w == (int)m_words.size())
+				return m_size;
+			word = m_words[w];
+		}
+		return (w << 6) + lowestBit(word);
+	}
+
+	int first() const { return next(0); }
+
+	void recount()
+	{
+		m_count = 0;
+		for (uint64_t word : m_words)
+			m_count += popCount(word);
+	}
+
+	// direct access for word-level operations, recount() must be called after modifications
+	std::vector<uint64_t>& words() { return m_words; }
+	const std::vector<uint64_t>& words() const { return m_words; }
+};
+
+#endif
@@ -20,12 +20,15 @@ along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
 #include <vector>
 #include <algorithm>
 #include <functional>
-#include <stack>
 #include <cassert>
 #include <iostream>
 #include <climits>
+#include <thread>
+#include <cstring>
+#include <cmath>
 
 #include "BnBAllocator.h"
+#include "AllocationCounter.h"
 
 // preprocess the input problem
 void BnBAllocator::preprocess()
@@ -33,9 +36,9 @@ void BnBAllocator::preprocess()
 	if (m_params.intelligentBound)
 	{
 		// compute number of initial VMs allocated to each PM, and also the number of PMs turned on in the initial assignment (required for bounding)
-		for (auto& vm : m_problem.VMs)
+		for (auto& pm : m_problem.PMs)
 		{
-			++(vm.initialPM->numAdditionalVMs);
+			pm.numAdditionalVMs = m_preprocessed->getNumInitialVMs(pm.id);
 		}
 		m_numAdditionalPMs = std::count_if(m_problem.PMs.cbegin(), m_problem.PMs.cend(), [](const PM& pm) {return pm.numAdditionalVMs > 0; });
 		m_maxNumVMsOnOnePM = std::max_element(m_problem.PMs.cbegin(), m_problem.PMs.cend(),
@@ -101,10 +104,29 @@ bool BnBAllocator::isAllocationValid()
 // allocates a VM to a PM
 void BnBAllocator::allocate(VM* VMHandled, PM* PMCandidate)
 {
-	assert(m_allocations.find(VMHandled) == m_allocations.end()); // we should only allocate unallocated VMs
+	(this->*m_allocateImpl)(VMHandled, PMCandidate);
+	m_stats.maxDepth = std::max(m_stats.maxDepth, (int)m_VMStack.size() + 1);
+	trace(TRACE_ALLOCATE, VMHandled->id, PMCandidate->id, 0);
+}
+
+// D is the dimension of resources if known at compile time, 0 otherwise
+template<int D>
+void BnBAllocator::allocateImpl(VM* VMHandled, PM* PMCandidate)
+{
+	int VMIndex = indexOf(VMHandled);
+	assert(m_allocatedPM[VMIndex] == -1); // we should only allocate unallocated VMs
+	bool turningOn = !(PMCandidate->isOn());
+
+	// the VM does not have to stay on its initial PM anymore, and the target PM has less free resources
+	if (m_params.overloadBound)
+	{
+		removeMustLeave(PMCandidate);
+		if (VMHandled->initialPM != nullptr && VMHandled->initialPM != PMCandidate)
+			removeMustLeave(VMHandled->initialPM);
+	}
 
 	//--Turning on a PM--
-	if (!(PMCandidate->isOn()))
+	if (turningOn)
 	{
 		m_numPMsOn++;
 
@@ -121,10 +143,67 @@ void BnBAllocator::allocate(VM* VMHandled, PM* PMCandidate)
 		}
 	}
 
+	if (m_params.forwardChecking)
+	{
+		// the PMs that were only available for this VM cannot be used anymore
+		const Bitset& availablePMs = VMHandled->availablePMs;
+		for (int pm = availablePMs.first(); pm < m_numPMs; pm = availablePMs.next(pm + 1))
+		{
+			if (--m_numVMsFitting[pm] == 0)
+			{
+				for (int i = 0; i < dimensionOf<D>(m_dimension); i++)
+					m_usableFree[i] -= m_problem.PMs[pm].resourcesFree[i];
+			}
+		}
+		if (m_numVMsFitting[PMCandidate->id] > 0)
+		{
+			for (int i = 0; i < dimensionOf<D>(m_dimension); i++)
+				m_usableFree[i] -= VMHandled->demand[i];
+		}
+	}
+
 	// reserve resources
-	m_allocations[VMHandled] = PMCandidate;
-	for (int i = 0; i < m_dimension; i++)
+	m_allocatedPM[VMIndex] = PMCandidate->id;
+	m_allocated.set(VMIndex);
+	if (m_params.failFirst)
+		m_VMQueue.remove(VMIndex);
+	for (int i = 0; i < dimensionOf<D>(m_dimension); i++)
+	{
 		PMCandidate->resourcesFree[i] -= VMHandled->demand[i];
+		m_unallocatedDemand[i] -= VMHandled->demand[i];
+	}
+	++PMCandidate->numVMs;
+	PMCandidate->updateFree();
+	m_resources.allocate<D>(VMIndex, PMCandidate->id);
+	if (m_packedSortKeys)
+		PMChanged(PMCandidate->id);
+
+	if (m_params.binPackingBound)
+	{
+		for (int i = 0; i < dimensionOf<D>(m_dimension); i++)
+		{
+			int freeAfter = PMCandidate->resourcesFree[i];
+			int freeBefore = freeAfter + VMHandled->demand[i];
+			if (!turningOn && 2LL * freeBefore > m_maxCapacity[i])
+				--m_numBigFreePMs[i];
+			if (2LL * freeAfter > m_maxCapacity[i])
+				++m_numBigFreePMs[i];
+			m_freeOnPMsOn[i] += turningOn ? freeAfter : -VMHandled->demand[i];
+			m_numBigVMs[i] -= m_isBig[VMIndex * m_dimension + i];
+		}
+	}
+
+	if (m_params.overloadBound)
+	{
+		if (VMHandled->initialPM != nullptr)
+		{
+			for (int i = 0; i < dimensionOf<D>(m_dimension); i++)
+				m_initialDemand[VMHandled->initialPM->id * m_dimension + i] -= VMHandled->demand[i];
+			if (VMHandled->initialPM != PMCandidate)
+				addMustLeave(VMHandled->initialPM);
+		}
+		addMustLeave(PMCandidate);
+	}
 
 	if (m_params.intelligentBound)
 	{
@@ -160,44 +239,126 @@ void BnBAllocator::allocate(VM* VMHandled, PM* PMCandidate)
 		#endif
 	}
 
+	// the classes of the target PM and the initial PM change
+	if (VMHandled->initialPM != nullptr)
+		--m_numUnallocatedInitialVMs[VMHandled->initialPM->id];
+	if (m_hashingPMs)
+	{
+		if (VMHandled->initialPM != nullptr && VMHandled->initialPM != PMCandidate)
+			updatePMHash(*VMHandled->initialPM);
+		updatePMHash(*PMCandidate);
+	}
+	if (m_nogoods.enabled())
+		m_unallocatedVMsHash ^= m_VMKeys[VMIndex];
+
+	// the VM becomes the last allocated VM of its chain
+	if (m_params.VMSymmetryBreaking && (m_previousInChain[VMIndex] != -1 || m_nextInChain[VMIndex] != -1))
+	{
+		int previous = m_previousInChain[VMIndex];
+		if (previous != -1)
+		{
+			--m_numChainEnds[m_allocatedPM[previous]];
+			m_chainEndsHash ^= chainEndHash(previous, m_allocatedPM[previous]);
+		}
+		if (m_nextInChain[VMIndex] != -1)
+			++m_numChainEnds[PMCandidate->id];
+		m_chainEndsHash ^= chainEndHash(VMIndex, PMCandidate->id);
+	}
+
 	//--Migrating a VM--
 	if (VMHandled->initialPM != nullptr && PMCandidate != VMHandled->initialPM)
 	{
 		m_numMigrations++;
 	}
 
-	Change change;
-	change.VMAllocated = VMHandled;
-	change.targetPM = PMCandidate;
+	m_trail.checkpoint();
 
 	// updating available PMs lists
-	for (int vmIndex = 0; vmIndex < m_numVMs; vmIndex++)
+	auto removeFromDomain = [this, PMCandidate](int vmIndex)
 	{
-		if (m_allocations.find(&m_problem.VMs[vmIndex]) != m_allocations.end()) // VM already allocated, no need to update its available PM list
+		Bitset& availablePMs = m_problem.VMs[vmIndex].availablePMs;
+		m_trail.record(vmIndex);
+		availablePMs.reset(PMCandidate->id);
+		if (m_params.failFirst)
+			m_VMQueue.update(vmIndex, availablePMs.count());
+		if (m_params.forwardChecking)
 		{
-			continue;
+			if (availablePMs.count() == 0)
+				++m_numEmptyDomains;
+			if (--m_numVMsFitting[PMCandidate->id] == 0)
+			{
+				for (int i = 0; i < dimensionOf<D>(m_dimension); i++)
+					m_usableFree[i] -= PMCandidate->resourcesFree[i];
+			}
 		}
-
-		std::vector<PM*>* availablePMs = &m_problem.VMs[vmIndex].availablePMs;
-		std::vector<PM*>::iterator found = std::find(availablePMs->begin(), availablePMs->end(), PMCandidate);
-
-		if (found != availablePMs->end() && !VMFitsInPM(m_problem.VMs[vmIndex], *PMCandidate)) // if the VM fitted onto the PM but doesn't fit anymore
+	};
+
+	// a VM whose largest demand is not more than the smallest free resource still fits, these VMs are at the end of the list of the PM type
+	int minFree = PMCandidate->resourcesFree[0];
+	for (int i = 1; i < dimensionOf<D>(m_dimension); i++)
+		minFree = std::min(minFree, PMCandidate->resourcesFree[i]);
+	const std::vector<int>& VMsByMaxDemand = m_VMsByMaxDemand[m_PMType[PMCandidate->id]];
+	size_t numAffected = std::partition_point(VMsByMaxDemand.begin(), VMsByMaxDemand.end(),
+		[this, minFree](int vm) { return m_maxDemand[vm] > minFree; }) - VMsByMaxDemand.begin();
+
+	// few VMs may be affected: they are checked one by one
+	if (numAffected * LOCAL_FIT_CHECK_FACTOR < (size_t)m_numVMs)
+	{
+		for (size_t k = 0; k < numAffected; k++)
 		{
-			change.doNotFitAnymore.push_back(&m_problem.VMs[vmIndex]);
-			availablePMs->erase(found);
+			int vmIndex = VMsByMaxDemand[k];
+			if (m_allocated.test(vmIndex) || !m_problem.VMs[vmIndex].availablePMs.test(PMCandidate->id))
+				continue;
+			if (!VMFitsInPM<D>(m_problem.VMs[vmIndex], *PMCandidate))
+				removeFromDomain(vmIndex);
 		}
+		return;
 	}
 
-	m_changeStack.push(change);
+	// otherwise unallocated VMs that do not fit onto the PM anymore are found with one pass over the VMs
+	m_resources.fittingVMs(PMCandidate->id, m_VMsFitting.data());
+	const std::vector<uint64_t>& allocatedWords = m_allocated.words();
+	for (size_t w = 0; w < m_VMsFitting.size(); w++)
+	{
+		uint64_t notFitting = ~m_VMsFitting[w] & ~allocatedWords[w]; // VM already allocated, no need to update its available PM list
+		if (w == m_VMsFitting.size() - 1 && m_numVMs % 64 != 0)
+			notFitting &= (uint64_t(1) << (m_numVMs % 64)) - 1; // bits after the last VM
+
+		while (notFitting != 0)
+		{
+			int vmIndex = (int)(w * 64) + lowestBit(notFitting);
+			notFitting &= notFitting - 1;
 
+			if (m_problem.VMs[vmIndex].availablePMs.test(PMCandidate->id)) // if the VM fitted onto the PM but doesn't fit anymore
+			{
+				assert(!VMFitsInPM<D>(m_problem.VMs[vmIndex], *PMCandidate));
+				removeFromDomain(vmIndex);
+			}
+		}
+	}
 }
 
 //deallocates a VM
 void BnBAllocator::deAllocate(VM* VMHandled)
 {
-	assert(m_allocations.find(VMHandled) != m_allocations.end()); // we should only deallocate VMs which were allocated
+	trace(TRACE_DEALLOCATE, VMHandled->id, m_allocatedPM[indexOf(VMHandled)], 0);
+	(this->*m_deAllocateImpl)(VMHandled);
+}
+
+template<int D>
+void BnBAllocator::deAllocateImpl(VM* VMHandled)
+{
+	int VMIndex = indexOf(VMHandled);
+	assert(m_allocatedPM[VMIndex] != -1); // we should only deallocate VMs which were allocated
 
-	PM* PMCandidate = m_allocations[VMHandled];
+	PM* PMCandidate = &m_problem.PMs[m_allocatedPM[VMIndex]];
+
+	if (m_params.overloadBound)
+	{
+		removeMustLeave(PMCandidate);
+		if (VMHandled->initialPM != nullptr && VMHandled->initialPM != PMCandidate)
+			removeMustLeave(VMHandled->initialPM);
+	}
 
 	if (m_params.intelligentBound)
 	{
@@ -222,9 +383,93 @@ void BnBAllocator::deAllocate(VM* VMHandled)
 	}
 
 	// free resources
-	m_allocations.erase(VMHandled);
-	for (int i = 0; i < m_dimension; i++)
+	m_allocatedPM[VMIndex] = -1;
+	m_allocated.reset(VMIndex);
+	if (m_params.failFirst)
+		m_VMQueue.insert(VMIndex, VMHandled->availablePMs.count());
+	for (int i = 0; i < dimensionOf<D>(m_dimension); i++)
+	{
 		PMCandidate->resourcesFree[i] += VMHandled->demand[i];
+		m_unallocatedDemand[i] += VMHandled->demand[i];
+	}
+	--PMCandidate->numVMs;
+	PMCandidate->updateFree();
+	m_resources.deAllocate<D>(VMIndex, PMCandidate->id);
+	if (m_packedSortKeys)
+		PMChanged(PMCandidate->id);
+
+	if (m_params.forwardChecking)
+	{
+		if (m_numVMsFitting[PMCandidate->id] > 0)
+		{
+			for (int i = 0; i < dimensionOf<D>(m_dimension); i++)
+				m_usableFree[i] += VMHandled->demand[i];
+		}
+		// the PMs available for this VM can be used again
+		const Bitset& availablePMs = VMHandled->availablePMs;
+		for (int pm = availablePMs.first(); pm < m_numPMs; pm = availablePMs.next(pm + 1))
+		{
+			if (m_numVMsFitting[pm]++ == 0)
+			{
+				for (int i = 0; i < dimensionOf<D>(m_dimension); i++)
+					m_usableFree[i] += m_problem.PMs[pm].resourcesFree[i];
+			}
+		}
+	}
+
+	if (m_params.binPackingBound)
+	{
+		bool turningOff = !(PMCandidate->isOn());
+		for (int i = 0; i < dimensionOf<D>(m_dimension); i++)
+		{
+			int freeAfter = PMCandidate->resourcesFree[i];
+			int freeBefore = freeAfter - VMHandled->demand[i];
+			if (2LL * freeBefore > m_maxCapacity[i])
+				--m_numBigFreePMs[i];
+			if (!turningOff && 2LL * freeAfter > m_maxCapacity[i])
+				++m_numBigFreePMs[i];
+			m_freeOnPMsOn[i] -= turningOff ? freeBefore : -VMHandled->demand[i];
+			m_numBigVMs[i] += m_isBig[VMIndex * m_dimension + i];
+		}
+	}
+
+	if (m_params.overloadBound)
+	{
+		if (VMHandled->initialPM != nullptr)
+		{
+			for (int i = 0; i < dimensionOf<D>(m_dimension); i++)
+				m_initialDemand[VMHandled->initialPM->id * m_dimension + i] += VMHandled->demand[i];
+			if (VMHandled->initialPM != PMCandidate)
+				addMustLeave(VMHandled->initialPM);
+		}
+		addMustLeave(PMCandidate);
+	}
+
+	// the classes of the target PM and the initial PM change
+	if (VMHandled->initialPM != nullptr)
+		++m_numUnallocatedInitialVMs[VMHandled->initialPM->id];
+	if (m_hashingPMs)
+	{
+		if (VMHandled->initialPM != nullptr && VMHandled->initialPM != PMCandidate)
+			updatePMHash(*VMHandled->initialPM);
+		updatePMHash(*PMCandidate);
+	}
+	if (m_nogoods.enabled())
+		m_unallocatedVMsHash ^= m_VMKeys[VMIndex];
+
+	// the previous VM becomes the last allocated VM of the chain again
+	if (m_params.VMSymmetryBreaking && (m_previousInChain[VMIndex] != -1 || m_nextInChain[VMIndex] != -1))
+	{
+		int previous = m_previousInChain[VMIndex];
+		if (previous != -1)
+		{
+			++m_numChainEnds[m_allocatedPM[previous]];
+			m_chainEndsHash ^= chainEndHash(previous, m_allocatedPM[previous]);
+		}
+		if (m_nextInChain[VMIndex] != -1)
+			--m_numChainEnds[PMCandidate->id];
+		m_chainEndsHash ^= chainEndHash(VMIndex, PMCandidate->id);
+	}
 
 	//--Turning on a PM--
 	if (!(PMCandidate->isOn()))
@@ -264,26 +509,25 @@ void BnBAllocator::deAllocate(VM* VMHandled)
 		m_numMigrations--;
 	}
 
-
-	Change change = m_changeStack.top();
-	m_changeStack.pop();
-
-	assert(*PMCandidate == *(change.targetPM)); // same PM should be saved in the Change as were in the allocation
-
-	for (size_t i = 0; i < change.doNotFitAnymore.size(); i++)
+	// the VMs that did not fit onto the PM after the allocation fit again
+	m_trail.restore([this, PMCandidate](int vmIndex)
 	{
-		VM* vmFitsAgain = change.doNotFitAnymore[i];
-		std::vector<PM*>::iterator found = std::find(vmFitsAgain->availablePMs.begin(), vmFitsAgain->availablePMs.end(), PMCandidate);
-		if (found == vmFitsAgain->availablePMs.end())
-		{
-			vmFitsAgain->availablePMs.push_back(PMCandidate); // adding the PM to the available PM list
-		}
-		else
+		Bitset& availablePMs = m_problem.VMs[vmIndex].availablePMs;
+		assert(!availablePMs.test(PMCandidate->id)); // PM can't already be in the list, because it was removed
+		if (m_params.forwardChecking)
 		{
-			assert(false); // PM can't already be in the list, because it was removed
+			if (availablePMs.count() == 0)
+				--m_numEmptyDomains;
+			if (m_numVMsFitting[PMCandidate->id]++ == 0)
+			{
+				for (int i = 0; i < dimensionOf<D>(m_dimension); i++)
+					m_usableFree[i] += PMCandidate->resourcesFree[i];
+			}
 		}
-	}
-
+		availablePMs.set(PMCandidate->id); // adding the PM to the available PM list
+		if (m_params.failFirst)
+			m_VMQueue.update(vmIndex, availablePMs.count());
+	});
 }
 
 // returns true if all VMs are allocated
@@ -292,12 +536,21 @@ bool BnBAllocator::allVMsAllocated()
 	return (signed)m_VMStack.size() == m_numVMs - 1;
 }
 
-// returns true if two PMs should be considered the same in symmetry breaking
+// returns true if two PMs are in the same class, i.e. they are interchangeable in the rest of the search
 bool BnBAllocator::PMsAreTheSame(const PM& pm1, const PM& pm2)
 {
-	for (int i = 0; i < m_dimension; i++)
+	return (this->*m_PMsAreTheSameImpl)(pm1, pm2);
+}
+
+template<int D>
+bool BnBAllocator::PMsAreTheSameImpl(const PM& pm1, const PM& pm2)
+{
+	if (m_PMType[pm1.id] != m_PMType[pm2.id] || m_numUnallocatedInitialVMs[pm1.id] > 0 || m_numUnallocatedInitialVMs[pm2.id] > 0)
+		return false;
+
+	for (int i = 0; i < dimensionOf<D>(m_dimension); i++)
 	{
-		if (!(pm1.capacity[i] == pm2.capacity[i] && pm1.resourcesFree[i] == pm1.capacity[i] && pm2.resourcesFree[i] == pm1.capacity[i]))
+		if (pm1.resourcesFree[i] != pm2.resourcesFree[i])
 			return false;
 	}
 
@@ -305,9 +558,10 @@ bool BnBAllocator::PMsAreTheSame(const PM& pm1, const PM& pm2)
 }
 
 // returns true if the VM fits in the PM
+template<int D>
 bool BnBAllocator::VMFitsInPM(const VM& vm, const PM& pm)
 {
-	for (int i = 0; i < m_dimension; i++)
+	for (int i = 0; i < dimensionOf<D>(m_dimension); i++)
 	{
 		if (pm.resourcesFree[i] < vm.demand[i])
 		{
@@ -321,98 +575,191 @@ bool BnBAllocator::VMFitsInPM(const VM& vm, const PM& pm)
 // returns the next VM
 VM* BnBAllocator::getNextVM()
 {
+	int next = -1;
+
 	// find VM candidate with smallest amount of available values
 	if (m_params.failFirst)
 	{
-		size_t min = INT_MAX;
-		VM* minVM = nullptr;
-		for (size_t i = 0; i < m_problem.VMs.size(); i++)
-		{
-			if (m_problem.VMs[i].availablePMs.size() < min && m_allocations.find(&m_problem.VMs[i]) == m_allocations.end()) // return unallocated VM with minimal possible PMs
-			{
-				min = m_problem.VMs[i].availablePMs.size();
-				minVM = &m_problem.VMs[i];
-			}
-		}
-
-		return minVM;
+		if (m_params.restarts) // random one among them
+			next = m_VMQueue.top(std::uniform_int_distribution<int>(0, m_VMQueue.numTop() - 1)(m_random));
+		else
+			next = m_VMQueue.top(); // unallocated VM with minimal possible PMs, first in sorted order among them
 	}
 	else
 	{
-		for (size_t i = 0; i < m_problem.VMs.size(); i++)
+		for (int i = 0; i < m_numVMs; i++)
 		{
-			if (m_allocations.find(&m_problem.VMs[i]) == m_allocations.end()) // return next unallocated VM
+			if (!m_allocated.test(i)) // next unallocated VM
 			{
-				return &m_problem.VMs[i];
+				next = i;
+				break;
 			}
 		}
 	}
+	assert(next != -1); // there should be an unallocated VM
+
+	// identical VMs are allocated in order (they have the same available PMs, so the same domain size in the queue)
+	if (m_params.VMSymmetryBreaking)
+	{
+		while (m_previousInChain[next] != -1 && !m_allocated.test(m_previousInChain[next]))
+			next = m_previousInChain[next];
+	}
 
-	assert(false); // should have returned already
-	return nullptr;
+	return &m_problem.VMs[next];
 }
 
-// initialize PM candidates for every VM
+// initialize PM candidates for every VM (in the order of PM IDs)
 void BnBAllocator::initializePMCandidates()
 {
 	for (int i = 0; i < m_numVMs; i++)
 	{
-		m_problem.VMs[i].PMIterator = m_problem.VMs[i].availablePMs.begin();
+		m_problem.VMs[i].candidates.reserve(m_numPMs); // the candidates are collected again when moving down, without allocating
+		m_problem.VMs[i].numEquivalentPMs.reserve(m_numPMs);
+		collectCandidates(&m_problem.VMs[i]);
+		m_problem.VMs[i].PMIterator = m_problem.VMs[i].candidates.begin();
+	}
+}
+
+// copies the available PMs of a VM into its candidate list, in the order of PM IDs
+// with symmetry breaking only the first PM of each class is a candidate, the classes are found with a hash table
+void BnBAllocator::collectCandidates(VM* VMHandled)
+{
+	const Bitset& availablePMs = VMHandled->availablePMs;
+	std::vector<PM*>& candidates = VMHandled->candidates;
+
+	// identical VMs go to PMs with non-decreasing IDs
+	int lowestPM = 0;
+	if (m_params.VMSymmetryBreaking && m_previousInChain[indexOf(VMHandled)] != -1)
+		lowestPM = m_allocatedPM[m_previousInChain[indexOf(VMHandled)]];
+
+	candidates.clear();
+	VMHandled->numEquivalentPMs.clear();
+	if (!m_params.symmetryBreaking)
+	{
+		for (int pm = availablePMs.next(lowestPM); pm < m_numPMs; pm = availablePMs.next(pm + 1))
+		{
+			candidates.push_back(&m_problem.PMs[pm]);
+			VMHandled->numEquivalentPMs.push_back(1);
+		}
+		return;
+	}
+
+	newClassStamp();
+	size_t mask = m_classSlots.size() - 1;
+	for (int pm = availablePMs.next(lowestPM); pm < m_numPMs; pm = availablePMs.next(pm + 1))
+	{
+		// PMs on the two sides of the last allocated VM of a chain are not interchangeable, the classes are started again
+		if (m_params.VMSymmetryBreaking && m_numChainEnds[pm] > 0)
+			newClassStamp();
+
+		PM* candidate = &m_problem.PMs[pm];
+		size_t slot = m_PMHashes[pm] & mask;
+		while (m_classSlotStamps[slot] == m_classStamp && !PMsAreTheSame(*candidates[m_classSlots[slot]], *candidate))
+			slot = (slot + 1) & mask;
+
+		if (m_classSlotStamps[slot] == m_classStamp) // the class already has a candidate
+		{
+			++m_classSize[candidates[m_classSlots[slot]]->id];
+			++m_stats.symmetrySkips;
+			continue;
+		}
+		m_classSlotStamps[slot] = m_classStamp;
+		m_classSlots[slot] = (int)candidates.size();
+		m_classSize[pm] = 1;
+		candidates.push_back(candidate);
+	}
+	for (PM* pm : candidates)
+		VMHandled->numEquivalentPMs.push_back(m_classSize[pm->id]);
+}
+
+// invalidates every slot of the class hash table
+void BnBAllocator::newClassStamp()
+{
+	if (++m_classStamp == 0) // wrapped around, old stamps could match again
+	{
+		std::fill(m_classSlotStamps.begin(), m_classSlotStamps.end(), 0);
+		m_classStamp = 1;
 	}
 }
 
 // returns true if current branch is exhausted in the search tree
 bool BnBAllocator::currentBranchExhausted(VM* VMHandled)
 {
-	return (VMHandled->PMIterator == VMHandled->availablePMs.end());
+	return (VMHandled->PMIterator == VMHandled->candidates.end());
 }
 
 // resets PM candidates for a VM
 void BnBAllocator::resetCandidates(VM* VMHandled)
 {
-	std::vector<PM*>* pms = &(VMHandled->availablePMs);
+	collectCandidates(VMHandled);
+	std::vector<PM*>* pms = &(VMHandled->candidates);
 
-	switch (m_params.PMSortMethod)
-	{
-	case NONE:
-		if (m_params.symmetryBreaking) 	// symmetry breaking -> sorted PMs required anyway
-			std::sort(pms->begin(), pms->end(), LexicographicPMComparator);
-		break;
-	case LEXICOGRAPHIC:
-		std::sort(pms->begin(), pms->end(), LexicographicPMComparator);
-		break;
-	case MAXIMUM:
-		std::sort(pms->begin(), pms->end(), MaximumPMComparator);
-		break;
-	case SUM:
-		std::sort(pms->begin(), pms->end(), SumPMComparator);
-		break;
-	default:
-		assert(false); // the enum has to take some value
-		break;
-	}
+	orderCandidates(*pms);
+
+	if (m_params.restarts)
+		shuffleTies(*pms);
 
 	// initial PM first -> bringing it to the start of the list
 	if (m_params.initialPMFirst)
 	{
-		for (size_t i = 0; i < pms->size(); i++)
-		{
-			PM* pm = (*pms)[i];
-			if (pm == VMHandled->initialPM)
-			{
-				pms->erase(pms->begin() + i); // erase
-				pms->insert(pms->begin(), pm); // insert to front
-				break;
-			}
-		}
+		auto initialPM = std::find(pms->begin(), pms->end(), VMHandled->initialPM);
+		if (initialPM != pms->end())
+			std::rotate(pms->begin(), initialPM, initialPM + 1);
+	}
+
+	// the counts follow the new order of the candidates
+	for (size_t i = 0; i < pms->size(); i++)
+		VMHandled->numEquivalentPMs[i] = m_params.symmetryBreaking ? m_classSize[(*pms)[i]->id] : 1;
+
+	VMHandled->PMIterator = VMHandled->candidates.begin();
+}
+
+// sorts the candidates according to PMSortMethod
+// with packed keys, many candidates are picked from the maintained order of every PM instead of sorting them
+void BnBAllocator::orderCandidates(std::vector<PM*>& pms)
+{
+	if (!m_PMComparator)
+		return;
+
+	if (!m_packedSortKeys)
+	{
+		std::sort(pms.begin(), pms.end(), m_PMComparator);
+		return;
+	}
+
+	updatePMOrder();
+
+	size_t sortCost = pms.size(); // n * log(n)
+	for (size_t n = pms.size(); n > 1; n /= 2)
+		sortCost += pms.size();
+	if (sortCost < (size_t)m_numPMs)
+	{
+		std::sort(pms.begin(), pms.end(), [this](PM* pm1, PM* pm2) { return m_PMOrder.less(pm1->id, pm2->id); });
+		assert(std::is_sorted(pms.begin(), pms.end(), m_PMComparator)); // the keys give the order of the comparator
+		return;
+	}
+
+	if (++m_candidateStamp == 0) // wrapped around, old stamps could match again
+	{
+		std::fill(m_candidateMarks.begin(), m_candidateMarks.end(), 0);
+		m_candidateStamp = 1;
 	}
+	for (PM* pm : pms)
+		m_candidateMarks[pm->id] = m_candidateStamp;
 
-	VMHandled->PMIterator = VMHandled->availablePMs.begin();
+	size_t numCandidates = 0;
+	for (const PMOrder::Entry& entry : m_PMOrder.order())
+	{
+		if (m_candidateMarks[entry.pm] == m_candidateStamp)
+			pms[numCandidates++] = &m_problem.PMs[entry.pm];
+	}
+	assert(numCandidates == pms.size());
+	assert(std::is_sorted(pms.begin(), pms.end(), m_PMComparator));
 }
 
 void BnBAllocator::saveVM(VM* VMHandled)
 {
-	m_VMStack.push(VMHandled);
+	m_VMStack.push_back(VMHandled);
 }
 
 // backtracks to previous VM and returns it
@@ -421,15 +768,17 @@ VM* BnBAllocator::backtrackToPreviousVM()
 	//stack should never be empty
 	assert(!(m_VMStack.empty()));
 
-	VM* top = m_VMStack.top();
-	m_VMStack.pop();
+	VM* top = m_VMStack.back();
+	m_VMStack.pop_back();
+	++m_stats.backtracks;
+	trace(TRACE_BACKTRACK, top->id, -1, 0);
 	return top;
 }
 
 // returns true if all possibilities are exhausted in the search tree
 bool BnBAllocator::allPossibilitiesExhausted()
 {
-	return m_VMStack.empty();
+	return m_VMStack.size() == m_rootDepth;
 }
 
 // returns next PM candidate for VM
@@ -443,133 +792,754 @@ PM* BnBAllocator::getNextPMCandidate(VM* VMHandled)
 // sets next PM candidate for VM (automatically called by getter)
 void BnBAllocator::setNextPMCandidate(VM* VMHandled)
 {
-	assert(VMHandled->PMIterator != VMHandled->availablePMs.end()); // there should still be more candidates
+	assert(VMHandled->PMIterator != VMHandled->candidates.end()); // there should still be more candidates
+
+	// the other PMs of the class of the candidate are not candidates (symmetry breaking)
+	VMHandled->PMIterator++;
+}
+
+double BnBAllocator::computeMinimalExtraCost()
+{
+	// VMs that have to leave PMs that are on: their migrations are unavoidable, and cannot be used for emptying PMs
+	int mustLeave = m_params.overloadBound ? m_numMustLeaveOn : 0;
 
-	// symmetry breaking, skip same PMs
-	if (m_params.symmetryBreaking)
+	int minimalExtraCost = mustLeave * COEFF_NR_OF_MIGRATIONS;
+	if (m_params.intelligentBound)
 	{
-		PM* prevPM;
-		PM* currPM;
-		do
-		{
-			prevPM = *(VMHandled->PMIterator);
+		int remainingMigrations = m_numMaxMigrations - m_numMigrations - mustLeave;
 
-			VMHandled->PMIterator++;
-			if (VMHandled->PMIterator == VMHandled->availablePMs.end())
-			{
+		minimalExtraCost += m_numAdditionalPMs * COEFF_NR_OF_ACTIVE_HOSTS;
+		int migrationsDone = 0;
+
+		for (int numVMs = 1; numVMs <= m_maxNumVMsOnOnePM; ++numVMs)
+		{
+			if (numVMs >= COEFF_NR_OF_ACTIVE_HOSTS / COEFF_NR_OF_MIGRATIONS)
 				break;
-			}
+			int numPMsEmptied = std::min(m_additionalVMCounts[numVMs], (remainingMigrations - migrationsDone) / numVMs);
+			migrationsDone += numPMsEmptied * numVMs;
+			minimalExtraCost -= (numPMsEmptied * COEFF_NR_OF_ACTIVE_HOSTS - numPMsEmptied * numVMs * COEFF_NR_OF_MIGRATIONS);
+		}
+	}
 
-			currPM = *(VMHandled->PMIterator);
+	// every PM turned on costs at least COEFF_NR_OF_ACTIVE_HOSTS
+	if (m_params.binPackingBound)
+		minimalExtraCost = std::max(minimalExtraCost, computeMinimalExtraPMs() * COEFF_NR_OF_ACTIVE_HOSTS + mustLeave * COEFF_NR_OF_MIGRATIONS);
 
-		} while (PMsAreTheSame(*prevPM, *currPM) && currPM != VMHandled->initialPM); // if this is the initial assignment, don't skip it
-	}
+	return minimalExtraCost;
+}
 
-	else
+// returns the number of PMs that have to be turned on at least to host the unallocated VMs, maximum over the dimensions of
+// - the volume bound: the demand not fitting into the free resources of the PMs already on, divided by the largest capacity
+// - the big VMs bound: VMs demanding more than half of the largest capacity need a separate PM each
+// these are the L1 bound of Martello and Toth and the J1 part of their L2 bound with alpha = C/2 only: there is no search over alpha,
+// and the volume of the medium VMs is not credited, so the bound stays O(dimensions) per node with heterogeneous, partly filled PMs
+int BnBAllocator::computeMinimalExtraPMs()
+{
+	int extraPMs = 0;
+	for (int i = 0; i < m_dimension; i++)
 	{
-		VMHandled->PMIterator++;
+		long long excess = m_unallocatedDemand[i] - m_freeOnPMsOn[i];
+		if (excess > 0)
+			extraPMs = std::max(extraPMs, (int)((excess + m_maxCapacity[i] - 1) / m_maxCapacity[i]));
+		extraPMs = std::max(extraPMs, m_numBigVMs[i] - m_numBigFreePMs[i]);
 	}
+	return extraPMs;
 }
 
-double BnBAllocator::computeMinimalExtraCost()
+// initializes the PM classes of the empty allocation
+void BnBAllocator::initializePMClasses()
 {
-	int remainingMigrations = m_numMaxMigrations - m_numMigrations;
-
-	int minimalExtraCost = m_numAdditionalPMs * COEFF_NR_OF_ACTIVE_HOSTS;
-	int migrationsDone = 0;
+	m_PMType = m_preprocessed->getPMTypes();
+	m_numUnallocatedInitialVMs.resize(m_numPMs);
+	for (int pm = 0; pm < m_numPMs; pm++)
+		m_numUnallocatedInitialVMs[pm] = m_preprocessed->getNumInitialVMs(pm);
 
-	for (int numVMs = 1; numVMs <= m_maxNumVMsOnOnePM; ++numVMs)
+	m_PMHashes.resize(m_numPMs);
+	m_PMsHash = 0;
+	for (const PM& pm : m_problem.PMs)
 	{
-		if (numVMs >= COEFF_NR_OF_ACTIVE_HOSTS / COEFF_NR_OF_MIGRATIONS)
-			break;
-		int numPMsEmptied = std::min(m_additionalVMCounts[numVMs], (remainingMigrations - migrationsDone) / numVMs);
-		migrationsDone += numPMsEmptied * numVMs;
-		minimalExtraCost -= (numPMsEmptied * COEFF_NR_OF_ACTIVE_HOSTS - numPMsEmptied * numVMs * COEFF_NR_OF_MIGRATIONS);
+		m_PMHashes[pm.id] = PMHash(pm);
+		m_PMsHash += stateHash(pm.id, m_PMHashes[pm.id]);
 	}
 
-	return minimalExtraCost;
+	// at most half of the slots are used
+	size_t numSlots = 1;
+	while (numSlots < 2 * (size_t)m_numPMs)
+		numSlots *= 2;
+	m_classSlots.assign(numSlots, 0);
+	m_classSlotStamps.assign(numSlots, 0);
+	m_classStamp = 0;
+	m_classSize.assign(m_numPMs, 1);
 }
 
-BnBAllocator::BnBAllocator(AllocationProblem pr, std::shared_ptr<AllocatorParams> pa, std::ofstream& l)
-	:m_problem(pr), m_log(l), m_additionalVMCounts(m_problem.VMs.size() + 1, 0)
+// hash of the class of a PM: its type (or ID if it has unallocated initial VMs) and its free resources
+uint64_t BnBAllocator::PMHash(const PM& pm)
 {
-	std::shared_ptr<BnBParams> params = std::dynamic_pointer_cast<BnBParams>(pa);
+	uint64_t hash = (m_numUnallocatedInitialVMs[pm.id] > 0) ? mixHash(((uint64_t)pm.id << 1) | 1) : mixHash((uint64_t)m_PMType[pm.id] << 1);
+	for (int i = 0; i < m_dimension; i++)
+		hash = mixHash(hash ^ (uint32_t)pm.resourcesFree[i]);
+	return hash;
+}
 
-	if (!params)
-		std::cout << "Error: invalid parameters type for BnBAllocator." << std::endl;
+// recomputes the hash of a PM whose class may have changed
+void BnBAllocator::updatePMHash(const PM& pm)
+{
+	uint64_t hash = PMHash(pm);
+	m_PMsHash += stateHash(pm.id, hash) - stateHash(pm.id, m_PMHashes[pm.id]);
+	m_PMHashes[pm.id] = hash;
+}
 
-	m_params = *params;
+// links the identical VMs into chains, in the order of their positions
+void BnBAllocator::initializeVMChains()
+{
+	m_previousInChain.assign(m_numVMs, -1);
+	m_nextInChain.assign(m_numVMs, -1);
+	m_numChainEnds.assign(m_numPMs, 0);
+	m_chainEndsHash = 0;
+
+	std::vector<int> lastOfChain(m_preprocessed->getNumVMClasses(), -1); // the last VM found in each class
+	int numChainedVMs = 0;
+	int numChains = 0;
+	for (int vm = 0; vm < m_numVMs; vm++)
+	{
+		int& last = lastOfChain[m_preprocessed->getVMClass(m_problem.VMs[vm].id)];
+		int previous = last;
+		last = vm;
+		if (previous == -1) // first VM of its kind
+			continue;
 
-	m_numVMs = m_problem.VMs.size();
-	m_numPMs = m_problem.PMs.size();
-	m_dimension = m_problem.VMs[0].demand.size(); // only works if all VMs have the same number of dimensions
+		m_previousInChain[vm] = previous;
+		m_nextInChain[previous] = vm;
 
-	// computing available migrations
-	m_numMaxMigrations = m_numPMs / m_params.maxMigrationsRatio;
+		numChainedVMs += (m_previousInChain[previous] == -1) ? 2 : 1;
+		numChains += (m_previousInChain[previous] == -1) ? 1 : 0;
+	}
 
-	// at the start there are no allocations
-	m_numMigrations = 0;
-	m_numPMsOn = 0;
-	m_bestCostSoFar = INT_MAX;
-	m_bestSoFarNumMigrations = INT_MAX;
-	m_bestSoFarNumPMsOn = INT_MAX;
+	#ifdef VERBOSE_BASIC
+		m_log << "Identical VMs: " << numChainedVMs << " VMs in " << numChains << " chains" << std::endl;
+	#endif
+}
 
-	for (int vm = 0; vm < m_numVMs; vm++)
+// initializes the hash of the unallocated VMs
+void BnBAllocator::initializeNogoodCache()
+{
+	m_nogoods = NogoodCache(m_params.nogoodCacheSize);
+
+	std::mt19937_64 random(0x5eed); // the keys only have to be distinct, the same in every run
+	m_VMKeys.resize(m_numVMs);
+	m_unallocatedVMsHash = 0;
+	for (auto& key : m_VMKeys)
 	{
-		for (int pm = 0; pm < m_numPMs; pm++)
-		{
-			if (VMFitsInPM(m_problem.VMs[vm], m_problem.PMs[pm])) // initialize available PMs list
-			{
-				m_problem.VMs[vm].availablePMs.push_back(&m_problem.PMs[pm]);
-			}
-		}
+		key = random();
+		m_unallocatedVMsHash ^= key;
 	}
+}
 
-	// saving initial PM for each VM
-	for (auto& vm : m_problem.VMs)
+// initializes the values of the overload bound for the empty allocation
+// the initial VMs of each PM are sorted by their demand in every dimension, so that the VMs that must leave can be counted quickly
+void BnBAllocator::initializeOverloadBound()
+{
+	m_initialVMsByDemand.assign((size_t)m_numPMs * m_dimension, std::vector<int>());
+	m_initialDemand.assign((size_t)m_numPMs * m_dimension, 0);
+	for (int vm = 0; vm < m_numVMs; vm++)
 	{
-		// newly created VM
-		if (vm.initialID == -1)
+		const VM& VMHandled = m_problem.VMs[vm];
+		if (VMHandled.initialPM == nullptr)
+			continue;
+		for (int i = 0; i < m_dimension; i++)
 		{
-			vm.initialPM = nullptr;
+			m_initialVMsByDemand[VMHandled.initialPM->id * m_dimension + i].push_back(vm);
+			m_initialDemand[VMHandled.initialPM->id * m_dimension + i] += VMHandled.demand[i];
 		}
-		// VM has an initial PM
-		else
+	}
+	for (int i = 0; i < m_dimension; i++)
+	{
+		for (int pm = 0; pm < m_numPMs; pm++)
 		{
-			vm.initialPM = &m_problem.PMs[vm.initialID];
+			std::vector<int>& VMs = m_initialVMsByDemand[pm * m_dimension + i];
+			std::sort(VMs.begin(), VMs.end(), [this, i](int vm1, int vm2)
+			{
+				return m_problem.VMs[vm1].demand[i] > m_problem.VMs[vm2].demand[i];
+			});
 		}
 	}
 
-	preprocess();
+	m_mustLeave.assign(m_numPMs, 0);
+	m_numMustLeave = 0;
+	m_numMustLeaveOn = 0;
+	for (auto& pm : m_problem.PMs)
+		addMustLeave(&pm);
+
+	#ifdef VERBOSE_BASIC
+		m_log << "Overloaded PMs: " << std::count_if(m_mustLeave.begin(), m_mustLeave.end(), [](int n) {return n > 0; })
+			<< ", VMs that have to migrate: " << m_numMustLeave << std::endl;
+	#endif
+}
+
+// removes the VMs that must leave the PM from the sums, called before the PM or its initial VMs change
+void BnBAllocator::removeMustLeave(PM* pm)
+{
+	m_numMustLeave -= m_mustLeave[pm->id];
+	if (pm->isOn())
+		m_numMustLeaveOn -= m_mustLeave[pm->id];
+}
+
+// recomputes the number of unallocated initial VMs that must leave the PM and adds it to the sums
+// in each dimension, the biggest VMs leaving have to free the resources the PM lacks (greedy cover), the maximum over the dimensions is a lower bound
+void BnBAllocator::addMustLeave(PM* pm)
+{
+	int mustLeave = 0;
+	for (int i = 0; i < m_dimension; i++)
+	{
+		long long lacking = m_initialDemand[pm->id * m_dimension + i] - pm->resourcesFree[i];
+		if (lacking <= 0)
+			continue;
+
+		int numLeaving = 0;
+		for (int vm : m_initialVMsByDemand[pm->id * m_dimension + i])
+		{
+			if (m_allocated.test(vm))
+				continue;
+			lacking -= m_problem.VMs[vm].demand[i];
+			numLeaving++;
+			if (lacking <= 0)
+				break;
+		}
+		mustLeave = std::max(mustLeave, numLeaving);
+	}
+
+	m_mustLeave[pm->id] = mustLeave;
+	m_numMustLeave += mustLeave;
+	if (pm->isOn())
+		m_numMustLeaveOn += mustLeave;
+}
+
+// initializes the values of the bin packing bound for the empty allocation
+void BnBAllocator::initializeBinPackingBound()
+{
+	m_maxCapacity.assign(m_dimension, 1);
+	for (const PM& pm : m_problem.PMs)
+		for (int i = 0; i < m_dimension; i++)
+			m_maxCapacity[i] = std::max(m_maxCapacity[i], pm.capacity[i]);
+
+	m_freeOnPMsOn.assign(m_dimension, 0);
+	m_numBigVMs.assign(m_dimension, 0);
+	m_numBigFreePMs.assign(m_dimension, 0);
+	m_isBig.assign((size_t)m_numVMs * m_dimension, 0);
+	for (int vm = 0; vm < m_numVMs; vm++)
+	{
+		for (int i = 0; i < m_dimension; i++)
+		{
+			int demand = m_problem.VMs[vm].demand[i];
+			if (2LL * demand > m_maxCapacity[i])
+			{
+				m_isBig[vm * m_dimension + i] = 1;
+				++m_numBigVMs[i];
+			}
+		}
+	}
+}
+
+// sorts the VMs fitting on an empty PM of each type by their largest demand
+void BnBAllocator::initializeFitIndex()
+{
+	m_maxDemand.resize(m_numVMs);
+	for (int vm = 0; vm < m_numVMs; vm++)
+		m_maxDemand[vm] = *std::max_element(m_problem.VMs[vm].demand.begin(), m_problem.VMs[vm].demand.end());
+
+	int numPMTypes = m_preprocessed->getNumPMTypes();
+	m_VMsByMaxDemand.assign(numPMTypes, std::vector<int>());
+	std::vector<bool> typeDone(numPMTypes, false);
+	for (const PM& pm : m_problem.PMs)
+	{
+		int type = m_PMType[pm.id];
+		if (typeDone[type])
+			continue;
+		typeDone[type] = true;
+		for (int vm = 0; vm < m_numVMs; vm++)
+		{
+			if (m_problem.VMs[vm].availablePMs.test(pm.id))
+				m_VMsByMaxDemand[type].push_back(vm);
+		}
+		std::stable_sort(m_VMsByMaxDemand[type].begin(), m_VMsByMaxDemand[type].end(), [this](int vm1, int vm2) { return m_maxDemand[vm1] > m_maxDemand[vm2]; });
+	}
+}
+
+// counts the unallocated VMs each PM is available for, in the empty allocation
+void BnBAllocator::initializeForwardChecking()
+{
+	m_numVMsFitting.assign(m_numPMs, 0);
+	m_numEmptyDomains = 0;
+	for (const VM& vm : m_problem.VMs)
+	{
+		for (int pm = vm.availablePMs.first(); pm < m_numPMs; pm = vm.availablePMs.next(pm + 1))
+			++m_numVMsFitting[pm];
+		if (vm.availablePMs.count() == 0)
+			++m_numEmptyDomains;
+	}
+
+	m_usableFree.assign(m_dimension, 0);
+	for (const PM& pm : m_problem.PMs)
+	{
+		if (m_numVMsFitting[pm.id] > 0)
+			for (int i = 0; i < m_dimension; i++)
+				m_usableFree[i] += pm.resourcesFree[i];
+	}
+}
+
+// returns true if the current allocation cannot be completed: an unallocated VM has no available PM,
+// or the unallocated VMs demand more than the free resources of the PMs available for them in some dimension
+bool BnBAllocator::propagationFailed()
+{
+	if (!m_params.forwardChecking)
+		return false;
+
+	bool failed = m_numEmptyDomains > 0;
+	for (int i = 0; i < m_dimension && !failed; i++)
+		failed = m_unallocatedDemand[i] > m_usableFree[i];
+	if (failed)
+		m_numDeadEnds++;
+	return failed;
+}
+
+// selects the comparator of the PMs, and computes their keys if they can be packed
+void BnBAllocator::initializePMOrder()
+{
+	switch (m_params.PMSortMethod)
+	{
+	case NONE:
+		m_PMComparator = nullptr;
+		break;
+	case LEXICOGRAPHIC:
+		m_PMComparator = LexicographicPMComparator;
+		break;
+	case MAXIMUM:
+		m_PMComparator = MaximumPMComparator;
+		break;
+	case SUM:
+		m_PMComparator = SumPMComparator;
+		break;
+	default:
+		assert(false); // the enum has to take some value
+		break;
+	}
+
+	int maxCapacity = 0;
+	for (const PM& pm : m_problem.PMs)
+		for (int i = 0; i < m_dimension; i++)
+			maxCapacity = std::max(maxCapacity, pm.capacity[i]);
+	m_sortKeyBits = 1;
+	while ((1LL << m_sortKeyBits) <= maxCapacity)
+		m_sortKeyBits++;
+
+	m_packedSortKeys = m_PMComparator != nullptr;
+	if (m_params.PMSortMethod == LEXICOGRAPHIC && m_sortKeyBits * m_dimension > 62)
+		m_packedSortKeys = false;
+
+	if (m_packedSortKeys)
+	{
+		std::vector<uint64_t> keys(m_numPMs);
+		for (PM& pm : m_problem.PMs)
+			keys[pm.id] = sortKey(pm);
+		m_PMOrder = PMOrder(keys);
+	}
+	m_candidateMarks.assign(m_numPMs, 0);
+	m_candidateStamp = 0;
+	m_changedPMs.clear();
+	m_changedPMs.reserve(m_numPMs);
+	m_PMChanged.assign(m_numPMs, false);
+}
+
+// notes that the key of the PM may have changed, the order is updated only when it is needed next
+// a PM is often allocated to and freed again before that, then its key is the same
+void BnBAllocator::PMChanged(int PMid)
+{
+	if (!m_PMChanged[PMid])
+	{
+		m_PMChanged[PMid] = true;
+		m_changedPMs.push_back(PMid);
+	}
+}
+
+// moves the changed PMs to their place in the order
+void BnBAllocator::updatePMOrder()
+{
+	for (int PMid : m_changedPMs)
+	{
+		uint64_t key = sortKey(m_problem.PMs[PMid]);
+		if (key != m_PMOrder.key(PMid))
+			m_PMOrder.update(PMid, key);
+		m_PMChanged[PMid] = false;
+	}
+	m_changedPMs.clear();
+}
+
+// the order of the comparator as a number: the PMs that are on come first, in ascending order of their free resources (best fit),
+// then the PMs that are off in descending order (the biggest one is turned on first), except for MaximumPMComparator, which sorts them in ascending order too
+uint64_t BnBAllocator::sortKey(PM& pm)
+{
+	const uint64_t VALUE_MASK = (uint64_t(1) << 62) - 1;
+	uint64_t value = 0;
+	if (m_params.PMSortMethod == LEXICOGRAPHIC)
+	{
+		for (int i = 0; i < m_dimension; i++)
+		{
+			assert(pm.resourcesFree[i] >= 0);
+			value = (value << m_sortKeyBits) | (uint64_t)pm.resourcesFree[i];
+		}
+	}
+	else
+	{
+		assert(pm.sumFree >= 0 && pm.maxFree >= 0);
+		value = (uint64_t)(m_params.PMSortMethod == MAXIMUM ? pm.maxFree : pm.sumFree);
+	}
+
+	if (pm.isOn())
+		return value;
+	return (uint64_t(1) << 62) | (m_params.PMSortMethod == MAXIMUM ? value : VALUE_MASK - value);
+}
+
+// sets the versions of the per-dimension functions to be used
+template<int D>
+void BnBAllocator::setDimension()
+{
+	m_allocateImpl = &BnBAllocator::allocateImpl<D>;
+	m_deAllocateImpl = &BnBAllocator::deAllocateImpl<D>;
+	m_PMsAreTheSameImpl = &BnBAllocator::PMsAreTheSameImpl<D>;
+}
+
+BnBAllocator::BnBAllocator(std::shared_ptr<const PreprocessedProblem> pr, std::shared_ptr<AllocatorParams> pa, std::ofstream& l)
+	:BnBAllocator(pr, pa, l, nullptr)
+{
+
+}
+
+BnBAllocator::BnBAllocator(std::shared_ptr<const PreprocessedProblem> pr, std::shared_ptr<AllocatorParams> pa, std::ofstream& l, WorkPool* pool)
+	:m_problem(pr->getProblem()), m_log(l), m_additionalVMCounts(m_problem.VMs.size() + 1, 0), m_preprocessed(pr), m_pool(pool)
+{
+	std::shared_ptr<BnBParams> params = std::dynamic_pointer_cast<BnBParams>(pa);
+
+	if (!params)
+		std::cout << "Error: invalid parameters type for BnBAllocator." << std::endl;
+
+	m_params = *params;
+
+	m_numVMs = m_problem.VMs.size();
+	m_numPMs = m_problem.PMs.size();
+	m_dimension = m_problem.VMs[0].demand.size(); // only works if all VMs have the same number of dimensions
+
+	// selecting the code specialized for the dimension of resources
+	switch (m_dimension)
+	{
+	case 1: setDimension<1>(); break;
+	case 2: setDimension<2>(); break;
+	case 3: setDimension<3>(); break;
+	case 4: setDimension<4>(); break;
+	case 5: setDimension<5>(); break;
+	case 6: setDimension<6>(); break;
+	case 7: setDimension<7>(); break;
+	case 8: setDimension<8>(); break;
+	default: setDimension<0>(); break; // generic version
+	}
+
+	// computing available migrations
+	m_numMaxMigrations = m_numPMs / m_params.maxMigrationsRatio;
+
+	// at the start there are no allocations
+	m_numMigrations = 0;
+	m_numPMsOn = 0;
+	m_bestCostSoFar = INT_MAX;
+	m_bestSoFarNumMigrations = INT_MAX;
+	m_bestSoFarNumPMsOn = INT_MAX;
+	m_rootDepth = 0;
+	m_timedOut = false;
+	m_timer.start(); // restarted by solve(), the time of an initial solution installed before is reported from here
+	m_pollInterval = 1;
+	m_nodesUntilPoll = 1;
+	m_lastPollTime = 0;
+	m_trace = nullptr;
+	m_globalLowerBound = -1;
+	m_random.seed(m_params.seed);
+	m_nodesUntilRestart = -1;
+	m_numRestarts = 0;
+
+	m_allocatedPM.assign(m_numVMs, -1);
+	m_allocated = Bitset(m_numVMs);
+	m_bestAllocatedPM.assign(m_numVMs, -1);
+	m_hasBestAllocation = false;
+
+	// saving initial PM for each VM
+	for (auto& vm : m_problem.VMs)
+	{
+		// newly created VM
+		if (vm.initialID == -1)
+		{
+			vm.initialPM = nullptr;
+		}
+		// VM has an initial PM
+		else
+		{
+			vm.initialPM = &m_problem.PMs[vm.initialID];
+		}
+	}
+
+	if (m_params.profile)
+	{
+		m_profiler = std::make_unique<PhaseProfiler>();
+		m_profiler->openCounters();
+	}
+	beginPhase(PHASE_PREPROCESS);
+
+	preprocess();
+	m_bounding = m_params.intelligentBound || m_params.binPackingBound || m_params.overloadBound;
+	initializePMClasses();
+	m_chainEndsHash = 0;
+	if (m_params.VMSymmetryBreaking)
+		initializeVMChains();
+	m_hashingPMs = m_params.symmetryBreaking || (m_params.nogoodCacheSize > 0 && m_params.numThreads == 1);
+	m_unallocatedDemand.assign(m_dimension, 0);
+	for (const VM& vm : m_problem.VMs)
+	{
+		for (int i = 0; i < m_dimension; i++)
+			m_unallocatedDemand[i] += vm.demand[i];
+	}
+	if (m_params.binPackingBound)
+		initializeBinPackingBound();
+	if (m_params.overloadBound)
+		initializeOverloadBound();
+	if (m_params.nogoodCacheSize > 0 && m_params.numThreads == 1) // in parallel search the workers have the caches
+		initializeNogoodCache();
+
+	// VMs are sorted now, the resource matrix refers to them by position
+	beginPhase(PHASE_FIT_MATRIX);
+	m_resources = ResourceMatrix(m_problem.VMs, m_problem.PMs, m_dimension);
+	m_VMsFitting.resize((m_numVMs + 63) / 64);
+	for (auto& vm : m_problem.VMs)
+	{
+		vm.availablePMs = m_preprocessed->getFittingPMs(vm.id); // initialize available PMs list
+	}
+	initializeFitIndex();
+	endPhase(PHASE_FIT_MATRIX);
+	m_numDeadEnds = 0;
+	if (m_params.forwardChecking)
+		initializeForwardChecking();
+	initializePMOrder();
+
+	// ties in the queue are broken according to the order of the VMs (they are linked at the front of their bucket, so the last one goes in first)
+	if (m_params.failFirst)
+	{
+		m_VMQueue = DomainSizeQueue(m_numVMs, m_numPMs);
+		for (int vm = m_numVMs - 1; vm >= 0; vm--)
+		{
+			m_VMQueue.insert(vm, m_problem.VMs[vm].availablePMs.count());
+		}
+	}
+
+	m_VMById.resize(m_numVMs);
+	for (auto& vm : m_problem.VMs)
+	{
+		m_VMById[vm.id] = &vm;
+	}
+
+	// the search itself does not allocate memory: every stack is preallocated for the deepest branch
+	// a VM loses each PM at most once in a branch, the trail grows beyond the reserved size only in very large problems
+	m_VMStack.reserve(m_numVMs);
+	m_trail.reserve(std::min((size_t)m_numVMs * m_numPMs, MAX_RESERVED_TRAIL_SIZE), m_numVMs);
+
+	endPhase(PHASE_PREPROCESS);
 }
 
 // solves the allocation problem and stores the results in member variables
 void BnBAllocator::solve()
 {
+	resetStats();
 	m_timer.start();
+	startTracing();
+	if (m_profiler)
+		m_profiler->openCounters(); // solve() may run on an other thread than the constructor
+	beginPhase(PHASE_SEARCH);
+
+	if (m_params.warmStart)
+	{
+		warmStart();
+	}
+
+	if (m_params.numThreads > 1)
+	{
+		solveInParallel();
+	}
+	else
+	{
+		VM* VMHandled = getNextVM(); // index of current VM
+		initializePMCandidates();
+
+		#ifdef VERBOSE_ALG_STEPS
+			m_log << std::endl << "Starting search..." << std::endl;
+		#endif
+
+		if (m_params.searchMode == BEST_FIRST)
+			bestFirstSearch();
+		else if (m_params.restarts)
+			searchWithRestarts();
+		else
+			depthFirstSearch(VMHandled);
+	}
+
+	endPhase(PHASE_SEARCH);
+	stopTracing();
+	m_initialSolutionPending = false; // also set by the warm start, which belongs to this solve()
+
+	double elapsed = m_timer.getElapsedTime();
+	m_stats.nodesPerSecond = (elapsed > 0) ? m_stats.nodes / elapsed : 0;
 
-	VM* VMHandled = getNextVM(); // index of current VM
-	initializePMCandidates();
+	#ifdef VERBOSE_BASIC
+		m_log << "Search: " << m_stats.nodes << " nodes (" << m_stats.nodesPerSecond << " per second), " << m_stats.boundCuts << " bound cuts, "
+			<< m_stats.migrationCuts << " migration cuts, " << m_stats.symmetrySkips << " symmetry skips, " << m_stats.backtracks << " backtracks, maximal depth "
+			<< m_stats.maxDepth << std::endl;
+		if (m_hasBestAllocation)
+			m_log << "Incumbents: first after " << m_stats.timeToFirstIncumbent << " s, best after " << m_stats.timeToBestIncumbent << " s" << std::endl;
+		if (m_params.nogoodCacheSize > 0)
+		{
+			long long lookups = m_nogoods.getNumLookups(), hits = m_nogoods.getNumHits();
+			m_log << "Nogood cache: " << lookups << " lookups, " << hits << " hits (" << (lookups > 0 ? 100.0 * hits / lookups : 0.0) << "%), "
+				<< lookups - hits << " misses, " << m_nogoods.getNumStored() << " stored" << std::endl;
+		}
+		if (m_params.forwardChecking)
+			m_log << "Forward checking: " << m_numDeadEnds << " dead ends" << std::endl;
+		if (m_timedOut)
+			m_log << (stopRequested() ? "STOPPED." : "TIMED OUT.") << std::endl;
+	#endif
+
+	if (m_profiler)
+	{
+		m_stats.phases = m_profiler->getPhases();
+		#ifdef VERBOSE_BASIC
+			logProfile();
+		#endif
+	}
+}
+
+// logs the totals of each phase, and the events of the search per node
+void BnBAllocator::logProfile()
+{
+	const std::vector<PhaseProfile>& phases = m_profiler->getPhases();
+	bool counters = phases[PHASE_SEARCH].counters[0] >= 0;
+	if (!counters)
+		m_log << "Profile: hardware counters are not available, only the time is measured" << std::endl;
+
+	for (int p = 0; p < NUM_PROFILE_PHASES; p++)
+	{
+		const PhaseProfile& phase = phases[p];
+		m_log << "Profile of " << profilePhaseName(p) << ": " << phase.calls << " calls, " << phase.time << " s";
+		if (phase.workerTime > 0)
+			m_log << " (" << phase.workerTime << " s on the workers)";
+		if (counters)
+		{
+			for (int c = 0; c < NUM_PROFILE_COUNTERS; c++)
+				m_log << ", " << phase.counters[c] << " " << profileCounterName(c);
+			if (phase.counters[COUNTER_CYCLES] > 0)
+				m_log << ", IPC " << (double)phase.counters[COUNTER_INSTRUCTIONS] / phase.counters[COUNTER_CYCLES];
+		}
+		m_log << std::endl;
+	}
+
+	if (m_stats.nodes > 0)
+	{
+		const PhaseProfile& search = phases[PHASE_SEARCH];
+		m_log << "Profile per node: " << search.time / m_stats.nodes * 1e9 << " ns";
+		if (counters)
+		{
+			for (int c = 0; c < NUM_PROFILE_COUNTERS; c++)
+				m_log << ", " << (double)search.counters[c] / m_stats.nodes << " " << profileCounterName(c);
+		}
+		m_log << std::endl;
+	}
+}
+
+// opens the trace file if tracing is on, the events of this thread are recorded from now on
+void BnBAllocator::startTracing()
+{
+	if (m_params.traceFile.empty())
+		return;
+
+	m_tracer = std::make_unique<Tracer>(m_params.traceFile);
+	if (!m_tracer->isOpen())
+	{
+		std::cout << "Error: cannot open trace file " << m_params.traceFile << ", tracing is off." << std::endl;
+		m_tracer.reset();
+		return;
+	}
+	m_trace = m_tracer->addThread();
+	trace(TRACE_START, m_numVMs, m_numPMs, 0);
+}
 
-	#ifdef VERBOSE_ALG_STEPS
-		m_log << std::endl << "Starting search..." << std::endl;
+// writes the remaining events to the trace file and closes it
+void BnBAllocator::stopTracing()
+{
+	if (!m_tracer)
+		return;
+
+	m_tracer->stop();
+	#ifdef VERBOSE_BASIC
+		m_log << "Trace: " << m_tracer->getNumWritten() << " events written to " << m_params.traceFile << ", " << m_tracer->getNumDropped() << " dropped" << std::endl;
 	#endif
+	m_trace = nullptr;
+	m_tracer.reset();
+}
+
+// returns true if the wall-clock or CPU timeout is reached or a stop was requested
+// the clocks are only read every m_pollInterval calls, the interval follows the speed of the search
+bool BnBAllocator::hasToStop()
+{
+	if (--m_nodesUntilPoll > 0)
+		return false;
+
+	double time = m_timer.getElapsedTime();
+	if (time - m_lastPollTime < TIMEOUT_POLL_PERIOD / 2 && m_pollInterval < MAX_POLL_INTERVAL)
+		m_pollInterval *= 2;
+	else if (time - m_lastPollTime > TIMEOUT_POLL_PERIOD * 2 && m_pollInterval > 1)
+		m_pollInterval /= 2;
+	m_nodesUntilPoll = m_pollInterval;
+	m_lastPollTime = time;
+
+	return time > m_params.timeout || (m_params.CPUTimeout > 0 && m_timer.getElapsedCPUTime() > m_params.CPUTimeout) || stopRequested();
+}
+
+// searches the subtree below the current allocation, starting with VMHandled
+// returns when the subtree is exhausted or the search is stopped
+void BnBAllocator::depthFirstSearch(VM* VMHandled)
+{
+	size_t allocationsAtStart = AllocationCounter::count(); // only counted with COUNT_ALLOCATIONS
+	m_incompleteDepth = -1;
 
 	while (1)
 	{
-		if (m_timer.getElapsedTime() > m_params.timeout) // check for timeout
+		if (hasToStop()) // check for timeout
 		{
-			#ifdef VERBOSE_BASIC
-				m_log << "TIMED OUT." << std::endl;
-			#endif
+			m_timedOut = true;
+			if (m_pool)
+				m_pool->stop(true);
 			break;
 		}
 
+		if (m_nodesUntilRestart == 0) // time for a restart
+			break;
+
+		if (m_pool)
+		{
+			if (m_pool->isStopped())
+				break;
+			if (m_pool->hasIdleWorkers())
+				donateWork(VMHandled);
+		}
+
 		if (currentBranchExhausted(VMHandled)) // current branch is exhausted
 		{
 			#ifdef VERBOSE_ALG_STEPS
 				m_log << "Current brach exhausted. ";
 			#endif
+			if (m_nogoods.enabled() && (int)m_VMStack.size() > m_incompleteDepth)
+				m_nogoods.insert(stateKey()); // there is no better solution below the current allocation
 			if (allPossibilitiesExhausted()) // all possibilities exhausted
 			{
 			#ifdef VERBOSE_ALG_STEPS
@@ -585,8 +1555,7 @@ void BnBAllocator::solve()
 			#ifdef VERBOSE_ALG_STEPS
 				m_log << "Deallocated VM " << VMHandled->id << ". ";
 				m_log << "Current allocation: ";
-				for (auto x : m_allocations)
-					m_log << x << " ";
+				logCurrentAllocation();
 				m_log << std::endl;
 			#endif
 			continue;
@@ -594,28 +1563,40 @@ void BnBAllocator::solve()
 
 		PM* PMCandidate = getNextPMCandidate(VMHandled);
 		allocate(VMHandled, PMCandidate); // allocate VM
+		++m_stats.nodes;
+		if (m_nodesUntilRestart > 0)
+			--m_nodesUntilRestart;
 		#ifdef VERBOSE_ALG_STEPS
-			m_log << "Allocated VM " << VMHandled->id << " to PM " << PMCandidate->id << ". ";
+			m_log << "Allocated VM " << VMHandled->id << " to PM " << PMCandidate->id << " (one of " << VMHandled->numEquivalentPMs[VMHandled->PMIterator - VMHandled->candidates.begin() - 1] << " equivalent PMs). ";
 			m_log << "Current allocation: ";
-				for (auto x : m_allocations)
-					m_log << x << " ";
+				logCurrentAllocation();
 			m_log << " -> ";
 		#endif
 		assert(isAllocationValid());
 
-		if (m_numMigrations > m_numMaxMigrations) // ran out of migrations
+		if (outOfMigrations()) // ran out of migrations
 		{
+			++m_stats.migrationCuts;
+			trace(TRACE_MIGRATION_CUT, VMHandled->id, PMCandidate->id, m_numMigrations + (m_params.overloadBound ? m_numMustLeave : 0));
 			deAllocate(VMHandled);
 			#ifdef VERBOSE_ALG_STEPS
 				m_log << "\tToo many migrations. Deallocated VM " << VMHandled->id << "." << std::endl;
 				m_log << "Current allocation: ";
-				for (auto x : m_allocations)
-					m_log << x << " ";
+				logCurrentAllocation();
 				m_log << std::endl;
 			#endif
 			continue;
 		}
 
+		if (propagationFailed()) // the other VMs cannot be allocated anymore
+		{
+			deAllocate(VMHandled);
+			#ifdef VERBOSE_ALG_STEPS
+				m_log << "\tDead end. Deallocated VM " << VMHandled->id << "." << std::endl;
+			#endif
+			continue;
+		}
+
 		double cost = COEFF_NR_OF_ACTIVE_HOSTS * m_numPMsOn + COEFF_NR_OF_MIGRATIONS * m_numMigrations;
 		#ifdef VERBOSE_ALG_STEPS
 			m_log << "numPMsOn = " << m_numPMsOn << ", numMigrations = " << m_numMigrations <<", cost is: "<< cost << ". " << std::endl;
@@ -623,23 +1604,27 @@ void BnBAllocator::solve()
 
 		double minimalTotalCost = cost;
 
-		if (m_params.intelligentBound)
+		if (m_bounding)
 		{
-			double extraCost = computeMinimalExtraCost();
+			double extraCost = searchMinimalExtraCost();
 			minimalTotalCost += extraCost;
 			#ifdef VERBOSE_ALG_STEPS
 				m_log << "Computed minimal extra cost = " << extraCost << ", minimal total cost = " << minimalTotalCost << std::endl;
 			#endif
 		}
 
+		if (m_pool) // the best solution may have been found by an other worker
+			m_bestCostSoFar = std::min(m_bestCostSoFar, m_pool->getBestCost());
+
 		if (minimalTotalCost >= m_bestCostSoFar * m_params.boundThreshold) // bound
 		{
+			++m_stats.boundCuts;
+			trace(TRACE_BOUND_CUT, VMHandled->id, PMCandidate->id, minimalTotalCost);
 			deAllocate(VMHandled);
 			#ifdef VERBOSE_ALG_STEPS
 				m_log << "\tBound. Deallocated VM " << VMHandled->id << "." << std::endl;
 				m_log << "Current allocation: ";
-				for (auto x : m_allocations)
-					m_log << x << " ";
+				logCurrentAllocation();
 				m_log << std::endl;
 			#endif
 			continue;
@@ -647,13 +1632,7 @@ void BnBAllocator::solve()
 
 		if (allVMsAllocated()) // all VMs allocated, updating bestSoFar
 		{
-			m_bestAllocation = m_allocations;
-			m_bestCostSoFar = cost;
-			m_bestSoFarNumPMsOn = m_numPMsOn;
-			m_bestSoFarNumMigrations = m_numMigrations;
-			#ifdef VERBOSE_COST_CHANGE
-				m_log << m_timer.getElapsedTime() << ", " << cost << std::endl;
-			#endif
+			updateBestSoFar(cost);
 			#ifdef VERBOSE_ALG_STEPS
 				m_log << "\tBest so far updated." << std::endl;
 			#endif
@@ -661,14 +1640,21 @@ void BnBAllocator::solve()
 			#ifdef VERBOSE_ALG_STEPS
 				m_log << "\tAlready at the last VM. Deallocated VM " << VMHandled->id << "." << std::endl;
 				m_log << "Current allocation: ";
-				for (auto x : m_allocations)
-					m_log << x << " ";
+				logCurrentAllocation();
 				m_log << std::endl;
 			#endif
 		}
+		else if (m_nogoods.enabled() && m_nogoods.contains(stateKey())) // the same state was already searched
+		{
+			deAllocate(VMHandled);
+			#ifdef VERBOSE_ALG_STEPS
+				m_log << "\tState already searched. Deallocated VM " << VMHandled->id << "." << std::endl;
+			#endif
+		}
 		else // move down in the tree
 		{
 			saveVM(VMHandled);
+			m_incompleteDepth = std::min(m_incompleteDepth, (int)m_VMStack.size() - 1);
 			VMHandled = getNextVM();
 			resetCandidates(VMHandled);
 			#ifdef VERBOSE_ALG_STEPS
@@ -676,36 +1662,585 @@ void BnBAllocator::solve()
 			#endif
 		}
 	}
+
+	// the steady state of the sequential search makes no heap allocations (workers allocate when sharing work)
+	size_t allocations = AllocationCounter::count() - allocationsAtStart;
+	#ifdef VERBOSE_BASIC
+		if (AllocationCounter::enabled() && !m_pool)
+			m_log << "Heap allocations during search: " << allocations << std::endl;
+	#endif
+	#if defined(COUNT_ALLOCATIONS) && !defined(VERBOSE_ALG_STEPS) && !defined(VERBOSE_COST_CHANGE)
+		assert(m_pool || reportsIncumbents() || allocations == 0); // the subscriber of the incumbents may allocate
+	#endif
+	(void)allocations;
+}
+
+// shuffles the runs of equivalent PMs in the sorted list, without a comparator every PM is equivalent
+void BnBAllocator::shuffleTies(std::vector<PM*>& pms)
+{
+	if (!m_PMComparator)
+	{
+		std::shuffle(pms.begin(), pms.end(), m_random);
+		return;
+	}
+
+	size_t begin = 0;
+	while (begin < pms.size())
+	{
+		size_t end = begin + 1;
+		while (end < pms.size() && (m_packedSortKeys ? m_PMOrder.key(pms[begin]->id) == m_PMOrder.key(pms[end]->id)
+			: !m_PMComparator(pms[begin], pms[end]))) // sorted, so pms[end] is not less than pms[begin]
+			end++;
+		if (end - begin > 1)
+			std::shuffle(pms.begin() + begin, pms.begin() + end, m_random);
+		begin = end;
+	}
+}
+
+// number of nodes in the given run (from 0) of the restarted search
+long long BnBAllocator::restartLimit(int run)
+{
+	if (m_params.restartSchedule == GEOMETRIC)
+	{
+		// clamped before the cast, a large run would overflow the conversion
+		double limit = m_params.restartBase * std::pow(m_params.restartFactor, run);
+		return (limit >= (double)LLONG_MAX / 2) ? LLONG_MAX / 2 : (long long)limit;
+	}
+
+	// Luby sequence: 1 1 2 1 1 2 4 1 1 2 1 1 2 4 8 ...
+	long long size = 1;
+	int exponent = 0;
+	while (size < run + 1)
+	{
+		size = 2 * size + 1;
+		exponent++;
+	}
+	long long x = run;
+	while (size - 1 != x)
+	{
+		size = (size - 1) / 2;
+		exponent--;
+		x = x % size;
+	}
+	return m_params.restartBase * (1LL << exponent);
+}
+
+// depth first search that is restarted from the root after the number of nodes given by the schedule
+// ties are broken randomly, so every run explores the tree in a different order; the best solution so far bounds every run
+void BnBAllocator::searchWithRestarts()
+{
+	for (int run = 0; ; run++)
+	{
+		m_nodesUntilRestart = std::max(restartLimit(run), 1LL);
+
+		VM* VMHandled = getNextVM();
+		resetCandidates(VMHandled);
+		depthFirstSearch(VMHandled);
+
+		if (m_nodesUntilRestart != 0 || m_timedOut) // the tree is exhausted or out of time
+			break;
+
+		// undoing every allocation
+		while (!m_VMStack.empty())
+		{
+			deAllocate(backtrackToPreviousVM());
+		}
+		m_numRestarts++;
+	}
+	m_nodesUntilRestart = -1;
+
+	#ifdef VERBOSE_BASIC
+		m_log << "Restarts: " << m_numRestarts << std::endl;
+	#endif
+}
+
+// expands the open node with the best bound until the memory limit is reached
+// from then on the best open node is searched depth first, with no new open nodes
+void BnBAllocator::bestFirstSearch()
+{
+	double cost = COEFF_NR_OF_ACTIVE_HOSTS * m_numPMsOn + COEFF_NR_OF_MIGRATIONS * m_numMigrations;
+	double rootBound = m_bounding ? cost + searchMinimalExtraCost() : cost;
+	updateGlobalLowerBound(rootBound);
+	expandCurrentNode(-1, rootBound);
+
+	bool diving = false;
+	while (!m_openNodes.empty())
+	{
+		if (hasToStop()) // check for timeout
+		{
+			m_timedOut = true;
+			break;
+		}
+
+		OpenNode best = m_openNodes.top();
+		m_openNodes.pop();
+		if (best.bound >= m_bestCostSoFar * m_params.boundThreshold) // the remaining open nodes are not better either
+			break;
+		updateGlobalLowerBound(best.bound);
+
+		moveToNode(best.node);
+
+		if (!diving && bestFirstMemoryUsed() > (size_t)m_params.bestFirstMemoryLimit * 1024 * 1024)
+		{
+			diving = true;
+			#ifdef VERBOSE_BASIC
+				m_log << "Best first search: memory limit reached with " << m_openNodes.size() << " open nodes, searching them depth first." << std::endl;
+			#endif
+		}
+
+		if (diving)
+		{
+			m_rootDepth = m_VMStack.size();
+			VM* VMHandled = getNextVM();
+			resetCandidates(VMHandled);
+			depthFirstSearch(VMHandled);
+			m_rootDepth = 0;
+			if (m_timedOut)
+				break;
+		}
+		else
+		{
+			expandCurrentNode(best.node, best.bound);
+		}
+	}
+
+	moveToNode(-1); // undoing every allocation
+	if (!m_timedOut && m_hasBestAllocation) // the search is complete, the best solution is optimal
+		updateGlobalLowerBound(m_bestCostSoFar);
+
+	m_openNodes = decltype(m_openNodes)();
+	m_nodes.clear();
+	m_nodes.shrink_to_fit();
+}
+
+// creates the children of the current allocation (the node) as open nodes, complete allocations update the best so far
+void BnBAllocator::expandCurrentNode(int node, double bound)
+{
+	VM* VMHandled = getNextVM();
+	resetCandidates(VMHandled);
+	int depth = (int)m_VMStack.size() + 1;
+
+	while (!currentBranchExhausted(VMHandled))
+	{
+		PM* PMCandidate = getNextPMCandidate(VMHandled);
+		allocate(VMHandled, PMCandidate);
+		++m_stats.nodes;
+
+		if (outOfMigrations())
+		{
+			++m_stats.migrationCuts;
+			trace(TRACE_MIGRATION_CUT, VMHandled->id, PMCandidate->id, m_numMigrations + (m_params.overloadBound ? m_numMustLeave : 0));
+		}
+		else if (!propagationFailed())
+		{
+			double cost = COEFF_NR_OF_ACTIVE_HOSTS * m_numPMsOn + COEFF_NR_OF_MIGRATIONS * m_numMigrations;
+			double minimalTotalCost = cost;
+			if (m_bounding)
+				minimalTotalCost += searchMinimalExtraCost();
+
+			if (minimalTotalCost < m_bestCostSoFar * m_params.boundThreshold)
+			{
+				if (allVMsAllocated())
+				{
+					updateBestSoFar(cost);
+				}
+				else
+				{
+					m_nodes.push_back({ node, indexOf(VMHandled), PMCandidate->id });
+					m_openNodes.push({ std::max(minimalTotalCost, bound), depth, (int)m_nodes.size() - 1 }); // the bound of the parent is also valid
+				}
+			}
+			else
+			{
+				++m_stats.boundCuts;
+				trace(TRACE_BOUND_CUT, VMHandled->id, PMCandidate->id, minimalTotalCost);
+			}
+		}
+
+		deAllocate(VMHandled);
+	}
+}
+
+// changes the current allocation to the one of the node (-1: the root), only the decisions not shared with it are undone
+void BnBAllocator::moveToNode(int node)
+{
+	m_targetPath.clear();
+	for (int n = node; n != -1; n = m_nodes[n].parent)
+		m_targetPath.push_back(n);
+	std::reverse(m_targetPath.begin(), m_targetPath.end());
+
+	size_t common = 0;
+	while (common < m_pathNodes.size() && common < m_targetPath.size() && m_pathNodes[common] == m_targetPath[common])
+		common++;
+
+	while (m_pathNodes.size() > common)
+	{
+		deAllocate(backtrackToPreviousVM());
+		m_pathNodes.pop_back();
+	}
+	for (size_t i = common; i < m_targetPath.size(); i++)
+	{
+		const SearchNode& decision = m_nodes[m_targetPath[i]];
+		VM* VMHandled = &m_problem.VMs[decision.VMIndex];
+		allocate(VMHandled, &m_problem.PMs[decision.PMid]);
+		saveVM(VMHandled);
+		m_pathNodes.push_back(m_targetPath[i]);
+	}
+}
+
+// memory used by the nodes of best first search, in bytes
+size_t BnBAllocator::bestFirstMemoryUsed()
+{
+	return m_nodes.capacity() * sizeof(SearchNode) + m_openNodes.size() * sizeof(OpenNode);
+}
+
+// the global lower bound is the best bound of the open nodes, it never decreases
+void BnBAllocator::updateGlobalLowerBound(double bound)
+{
+	if (bound > m_globalLowerBound)
+	{
+		m_globalLowerBound = bound;
+		#ifdef VERBOSE_BASIC
+			m_log << "Global lower bound: " << bound << " (" << m_timer.getElapsedTime() << " s)" << std::endl;
+		#endif
+	}
+}
+
+// saves the current (complete) allocation as the best so far
+void BnBAllocator::updateBestSoFar(double cost)
+{
+	beginPhase(PHASE_INCUMBENT);
+	trace(TRACE_INCUMBENT, -1, -1, cost);
+	m_bestCostSoFar = cost;
+	m_bestSoFarNumPMsOn = m_numPMsOn;
+	m_bestSoFarNumMigrations = m_numMigrations;
+
+	if (m_pool)
+	{
+		m_pool->offerSolution(cost, m_numPMsOn, m_numMigrations, getCurrentDecisions());
+	}
+	else
+	{
+		std::memcpy(m_bestAllocatedPM.data(), m_allocatedPM.data(), m_numVMs * sizeof(int));
+		m_hasBestAllocation = true;
+		#ifdef VERBOSE_COST_CHANGE
+			m_log << m_timer.getElapsedTime() << ", " << cost << std::endl;
+		#endif
+		recordIncumbentTime(m_timer.getElapsedTime());
+		reportBestSoFar();
+	}
+	endPhase(PHASE_INCUMBENT);
+}
+
+// sends the best allocation so far to the subscriber of the incumbents, if there is one
+void BnBAllocator::reportBestSoFar()
+{
+	if (!reportsIncumbents())
+		return;
+
+	m_incumbentPMs.resize(m_numVMs);
+	for (int vm = 0; vm < m_numVMs; vm++)
+		m_incumbentPMs[m_problem.VMs[vm].id] = m_bestAllocatedPM[vm];
+	reportIncumbent(m_bestCostSoFar, m_bestSoFarNumPMsOn, m_bestSoFarNumMigrations, m_timer.getElapsedTime(), m_incumbentPMs);
+}
+
+// runs the greedy heuristic and installs its solution as the best so far (its running time counts into the timeout)
+void BnBAllocator::warmStart()
+{
+	GreedyAllocator greedy(m_preprocessed, std::make_shared<AllocatorParams>(m_params), m_log);
+	greedy.solve();
+
+	bool installed = setInitialSolution(greedy.getBestAllocation());
+
+	#ifdef VERBOSE_BASIC
+		if (installed)
+			m_log << "Warm start: initial best cost is " << m_bestCostSoFar << " (" << m_timer.getElapsedTime() << " s)" << std::endl;
+		else
+			m_log << "Warm start: the heuristic found no valid allocation." << std::endl;
+	#endif
+	(void)installed;
+}
+
+bool BnBAllocator::setInitialSolution(const AllocationMapType& allocation)
+{
+	std::vector<int> PMIdOfVM(m_numVMs, -1);
+	for (const auto& vmAndPM : allocation)
+	{
+		int VMid = vmAndPM.first->id;
+		if (VMid < 0 || VMid >= m_numVMs)
+			return false;
+		PMIdOfVM[VMid] = vmAndPM.second->id;
+	}
+	return setInitialSolution(PMIdOfVM);
+}
+
+bool BnBAllocator::setInitialSolution(const std::vector<int>& PMIdOfVM)
+{
+	if ((signed)PMIdOfVM.size() != m_numVMs)
+		return false;
+
+	// checking capacities on a copy of the free resources, the search state is not touched
+	std::vector<std::vector<int>> resourcesFree(m_numPMs);
+	for (int pm = 0; pm < m_numPMs; pm++)
+		resourcesFree[pm] = m_problem.PMs[pm].capacity;
+
+	std::vector<bool> PMOn(m_numPMs, false);
+	int numPMsOn = 0;
+	int numMigrations = 0;
+	for (int vm = 0; vm < m_numVMs; vm++)
+	{
+		const VM* VMHandled = m_VMById[vm];
+		int pm = PMIdOfVM[vm];
+		if (pm < 0 || pm >= m_numPMs) // not allocated
+			return false;
+
+		for (int i = 0; i < m_dimension; i++)
+		{
+			resourcesFree[pm][i] -= VMHandled->demand[i];
+			if (resourcesFree[pm][i] < 0) // constraint violated
+				return false;
+		}
+		if (!PMOn[pm])
+		{
+			PMOn[pm] = true;
+			numPMsOn++;
+		}
+		if (VMHandled->initialPM != nullptr && pm != VMHandled->initialPM->id)
+			numMigrations++;
+	}
+	if (numMigrations > m_numMaxMigrations)
+		return false;
+
+	double cost = COEFF_NR_OF_ACTIVE_HOSTS * numPMsOn + COEFF_NR_OF_MIGRATIONS * numMigrations;
+	if (m_hasBestAllocation && cost >= m_bestCostSoFar) // not better than the one we already have
+		return true;
+
+	for (int vm = 0; vm < m_numVMs; vm++)
+		m_bestAllocatedPM[indexOf(m_VMById[vm])] = PMIdOfVM[vm];
+	m_hasBestAllocation = true;
+	m_bestCostSoFar = cost;
+	m_bestSoFarNumPMsOn = numPMsOn;
+	m_bestSoFarNumMigrations = numMigrations;
+	#ifdef VERBOSE_COST_CHANGE
+		m_log << m_timer.getElapsedTime() << ", " << cost << std::endl;
+	#endif
+	trace(TRACE_INCUMBENT, -1, -1, cost);
+	recordIncumbentTime(m_timer.getElapsedTime());
+	m_initialSolutionPending = true;
+	reportBestSoFar();
+
+	return true;
+}
+
+// returns the current allocation as a list of decisions
+Subtree BnBAllocator::getCurrentDecisions()
+{
+	Subtree decisions;
+	for (int vm = 0; vm < m_numVMs; vm++)
+	{
+		if (m_allocatedPM[vm] != -1)
+			decisions.push_back({ m_problem.VMs[vm].id, m_allocatedPM[vm] });
+	}
+	return decisions;
+}
+
+// searches the tree with several worker threads
+// every worker has its own copy of the search state (the preprocessed problem is shared), they share the open subtrees and the best solution
+void BnBAllocator::solveInParallel()
+{
+	WorkPool pool(m_params.numThreads);
+
+	std::shared_ptr<BnBParams> workerParams = std::make_shared<BnBParams>(m_params);
+	workerParams->numThreads = 1;
+
+	// the initial solution (if any) bounds the search of the workers from the start
+	if (m_hasBestAllocation)
+	{
+		Subtree allocation;
+		for (int vm = 0; vm < m_numVMs; vm++)
+			allocation.push_back({ m_problem.VMs[vm].id, m_bestAllocatedPM[vm] });
+		pool.offerSolution(m_bestCostSoFar, m_bestSoFarNumPMsOn, m_bestSoFarNumMigrations, allocation);
+	}
+
+	// the solutions of the workers are the incumbents of this allocator, the pool reports the ones that are better
+	pool.setImprovementCallback([this](double cost, int numPMsOn, int numMigrations, const Subtree& allocation)
+	{
+		recordIncumbentTime(m_timer.getElapsedTime());
+		if (!reportsIncumbents())
+			return;
+		m_incumbentPMs.resize(m_numVMs);
+		for (const auto& decision : allocation)
+			m_incumbentPMs[decision.VMid] = decision.PMid;
+		reportIncumbent(cost, numPMsOn, numMigrations, m_stats.timeToBestIncumbent, m_incumbentPMs);
+	});
+
+	// the whole tree is the first subtree
+	std::vector<Subtree> root(1);
+	pool.addWork(root);
+
+	// every worker builds its search state on its own thread, so the workers are set up in parallel
+	std::vector<std::unique_ptr<BnBAllocator>> workers(m_params.numThreads);
+	std::vector<std::thread> threads;
+	for (auto& worker : workers)
+	{
+		threads.push_back(std::thread([this, &worker, &workerParams, &pool]()
+		{
+			worker.reset(new BnBAllocator(m_preprocessed, workerParams, m_log, &pool));
+			worker->m_timer = m_timer; // timeout is measured from the start of this search
+			worker->setStopToken(m_stopToken);
+			if (m_tracer)
+				worker->m_trace = m_tracer->addThread();
+			worker->work();
+		}));
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	for (auto& worker : workers)
+	{
+		m_nogoods.addStatistics(worker->m_nogoods);
+		m_numDeadEnds += worker->m_numDeadEnds;
+		m_stats.nodes += worker->m_stats.nodes;
+		m_stats.boundCuts += worker->m_stats.boundCuts;
+		m_stats.migrationCuts += worker->m_stats.migrationCuts;
+		m_stats.symmetrySkips += worker->m_stats.symmetrySkips;
+		m_stats.backtracks += worker->m_stats.backtracks;
+		m_stats.maxDepth = std::max(m_stats.maxDepth, worker->m_stats.maxDepth);
+		if (m_profiler)
+			m_profiler->add(*worker->m_profiler);
+	}
+
+	m_timedOut = pool.timedOut();
+	if (pool.hasSolution())
+	{
+		for (const auto& decision : pool.getBestAllocation())
+		{
+			m_bestAllocatedPM[indexOf(m_VMById[decision.VMid])] = decision.PMid;
+		}
+		m_hasBestAllocation = true;
+		m_bestCostSoFar = pool.getBestCost();
+		m_bestSoFarNumPMsOn = pool.getBestNumPMsOn();
+		m_bestSoFarNumMigrations = pool.getBestNumMigrations();
+	}
+}
+
+// main loop of a worker thread
+void BnBAllocator::work()
+{
+	if (m_profiler)
+		m_profiler->openCounters(); // the events of the worker thread
+	beginPhase(PHASE_SEARCH);
+
+	Subtree subtree;
+	while (m_pool->getWork(subtree))
+	{
+		searchSubtree(subtree);
+	}
+
+	endPhase(PHASE_SEARCH);
+}
+
+// searches a subtree taken from the pool
+void BnBAllocator::searchSubtree(const Subtree& subtree)
+{
+	// replaying the decisions leading to the subtree
+	for (const auto& decision : subtree)
+	{
+		VM* VMHandled = m_VMById[decision.VMid];
+		allocate(VMHandled, &m_problem.PMs[decision.PMid]);
+		saveVM(VMHandled);
+	}
+	m_rootDepth = m_VMStack.size();
+
+	if (subtree.empty()) // root of the search tree
+	{
+		VM* VMHandled = getNextVM();
+		initializePMCandidates();
+		depthFirstSearch(VMHandled);
+	}
+	else
+	{
+		// the subtree might have become useless since it was created
+		double cost = COEFF_NR_OF_ACTIVE_HOSTS * m_numPMsOn + COEFF_NR_OF_MIGRATIONS * m_numMigrations;
+		double minimalTotalCost = cost;
+		if (m_bounding)
+			minimalTotalCost += searchMinimalExtraCost();
+		m_bestCostSoFar = std::min(m_bestCostSoFar, m_pool->getBestCost());
+
+		if (!outOfMigrations() && minimalTotalCost < m_bestCostSoFar * m_params.boundThreshold)
+		{
+			if ((signed)m_VMStack.size() == m_numVMs) // all VMs allocated
+			{
+				updateBestSoFar(cost);
+			}
+			else
+			{
+				VM* VMHandled = getNextVM();
+				resetCandidates(VMHandled);
+				depthFirstSearch(VMHandled);
+			}
+		}
+	}
+
+	// undoing every allocation
+	m_rootDepth = 0;
+	while (!m_VMStack.empty())
+	{
+		deAllocate(backtrackToPreviousVM());
+	}
+}
+
+// gives the unexplored branches of the shallowest level to the pool, so that idle workers can take them
+void BnBAllocator::donateWork(VM* VMHandled)
+{
+	for (size_t depth = m_rootDepth; depth <= m_VMStack.size(); depth++)
+	{
+		VM* vm = (depth < m_VMStack.size()) ? m_VMStack[depth] : VMHandled;
+		if (currentBranchExhausted(vm))
+			continue;
+		m_incompleteDepth = std::max(m_incompleteDepth, (int)depth); // the rest of the branch is searched by other workers
+
+		Subtree prefix;
+		for (size_t i = 0; i < depth; i++)
+		{
+			prefix.push_back({ m_VMStack[i]->id, m_allocatedPM[indexOf(m_VMStack[i])] });
+		}
+
+		std::vector<Subtree> subtrees;
+		while (!currentBranchExhausted(vm))
+		{
+			subtrees.push_back(prefix);
+			subtrees.back().push_back({ vm->id, getNextPMCandidate(vm)->id });
+		}
+		m_pool->addWork(subtrees);
+		return;
+	}
 }
 
 // returns the cost of the best allocation found, or -1 when no allocation was found
 double BnBAllocator::getBestCost()
 {
 	#ifdef VERBOSE_BASIC
-		// unfortunately, printing VMs sorted according to ID this way is O(numVMs^2)
 		m_log << "alloc:\t";
-		for (int i = 0; i < m_numVMs; i++)
+		if (m_hasBestAllocation)
 		{
-			for (const auto& iter : m_bestAllocation)
+			for (int i = 0; i < m_numVMs; i++)
 			{
-				if (iter.first->id == i)
-				{
-					m_log << iter.first->id << "->" << iter.second->id << " ";
-					break;
-				}
+				m_log << i << "->" << m_bestAllocatedPM[indexOf(m_VMById[i])] << " ";
 			}
 		}
 		m_log << std::endl;
 	#endif
 
-		return (m_bestAllocation.empty()) ? -1 : m_bestCostSoFar;
+		return bestCostValue();
 }
 
 // computes an initial lower bound for the optimum
 // must be called before the start of the algorithm, but after preprocessing
 double BnBAllocator::getLowerBound()
 {
-	return computeMinimalExtraCost();
+	return computeMinimalExtraCost(); // before the search, not counted in the bound phase
 }
 
 // get cost components
@@ -719,7 +2254,26 @@ int BnBAllocator::getMigrations()
 	return m_bestSoFarNumMigrations;
 }
 
+// the map is only built here, the search works with PM IDs indexed by VM position
 const AllocationMapType& BnBAllocator::getBestAllocation()
 {
+	m_bestAllocation.clear();
+	if (m_hasBestAllocation)
+	{
+		for (int vm = 0; vm < m_numVMs; vm++)
+		{
+			m_bestAllocation[&m_problem.VMs[vm]] = &m_problem.PMs[m_bestAllocatedPM[vm]];
+		}
+	}
 	return m_bestAllocation;
 }
+
+// logs the current allocation as VM ID -> PM ID pairs
+void BnBAllocator::logCurrentAllocation()
+{
+	for (int vm = 0; vm < m_numVMs; vm++)
+	{
+		if (m_allocatedPM[vm] != -1)
+			m_log << m_problem.VMs[vm].id << "->" << m_allocatedPM[vm] << " ";
+	}
+}
@@ -22,15 +22,25 @@ along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
 
 #include <vector>
 #include <memory>
-#include <stack>
 #include <fstream>
+#include <queue>
+#include <random>
 
 #include "VMAllocator.h"
-#include "Change.h"
+#include "Trail.h"
 #include "AllocationProblem.h"
+#include "PreprocessedProblem.h"
 #include "BnBParams.h"
 #include "Timer.h"
 #include "PM.h"
+#include "WorkPool.h"
+#include "DomainSizeQueue.h"
+#include "PMOrder.h"
+#include "ResourceMatrix.h"
+#include "GreedyAllocator.h"
+#include "NogoodCache.h"
+#include "Trace.h"
+#include "PhaseProfiler.h"
 
 #define VERBOSE_BASIC // logging configuration, input problem and the solution
 
@@ -38,21 +48,93 @@ along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
 //#define VERBOSE_ALG_STEPS // logging steps of the algorithm in a human readable form
 //#define VERBOSE_COST_CHANGE // logging how the "best cost so far" changes (with timestamp)
 
+#define MAX_RESERVED_TRAIL_SIZE ((size_t)1 << 20) // entries preallocated for the trail at most (4 MB)
+#define TIMEOUT_POLL_PERIOD 0.001 // seconds between two checks of the timeouts and the stop token, the number of nodes in between is adapted to it
+#define MAX_POLL_INTERVAL (1 << 16) // nodes between two checks at most
+#define LOCAL_FIT_CHECK_FACTOR 8 // VMs checked one by one after an allocation if they are fewer than 1/8 of all VMs, otherwise the resource matrix is used
+
 class BnBAllocator : public VMAllocator
 {
-	AllocationProblem m_problem; // the allocation problem
+	AllocationProblem m_problem; // the allocation problem, a copy of the input holding the state of the search
 	BnBParams m_params; // algorithm parameters
 
 	int m_dimension; // dimension of resources
 	int m_numVMs; // number of Virtual Machines
 	int m_numPMs; // number of Physical Machines
 
+	ResourceMatrix m_resources; // free resources of PMs and demands of VMs (by position) for vectorized fit checks
+	std::vector<uint64_t> m_VMsFitting; // bitset words filled by the resource matrix in allocate()
+	std::vector<std::vector<int>> m_VMsByMaxDemand; // for each PM type, the VMs (by position) fitting on an empty PM of the type, in descending order of their largest demand
+	std::vector<int> m_maxDemand; // largest demand of each VM (by position)
+
 	int m_numAdditionalPMs; // number of additional PMs required if we now leave all VMs on their initial PM
 	int m_maxNumVMsOnOnePM; // maximal number of "initial VMs" on one PM (initialized once, but not maintained)
 	std::vector<int> m_additionalVMCounts; // maps number of occurences to each "additional VM count"
 
-	AllocationMapType m_allocations; // current allocations
-	AllocationMapType m_bestAllocation; // best allocation so far
+	// bin packing bound, every value is maintained for each dimension
+	std::vector<int> m_maxCapacity; // largest capacity of a PM
+	std::vector<long long> m_unallocatedDemand; // total demand of the unallocated VMs (also used by forward checking)
+	std::vector<long long> m_freeOnPMsOn; // total free resources of the PMs that are on
+	std::vector<int> m_numBigVMs; // unallocated VMs demanding more than half of the largest capacity, no two of them fit on one PM
+	std::vector<int> m_numBigFreePMs; // PMs on with more than half of the largest capacity free, the only ones that can host a big VM
+	std::vector<char> m_isBig; // for each VM position and dimension
+
+	// overload bound: the unallocated initial VMs of a PM that cannot all stay on it, some of them have to migrate
+	std::vector<std::vector<int>> m_initialVMsByDemand; // initial VMs (by position) of each PM in descending order of demand, for each PM and dimension
+	std::vector<long long> m_initialDemand; // total demand of the unallocated initial VMs, for each PM and dimension
+	std::vector<int> m_mustLeave; // minimal number of unallocated initial VMs that have to leave each PM
+	int m_numMustLeave; // sum for all PMs
+	int m_numMustLeaveOn; // sum for the PMs that are on (these cannot be emptied, so the migrations are not counted by intelligentBound)
+
+	bool m_bounding; // a lower bound is computed for partial allocations (intelligentBound, binPackingBound or overloadBound)
+
+	// order of the PM candidates: the comparator of PMSortMethod as a packed key of each PM, updated lazily after the free resources of the PM change
+	bool(*m_PMComparator)(PM*, PM*); // nullptr if the candidates are not sorted
+	bool m_packedSortKeys; // false if the key does not fit into 64 bits (lexicographic order of many dimensions), then the comparator is used
+	int m_sortKeyBits; // bits for one dimension in the lexicographic key
+	PMOrder m_PMOrder; // every PM in the order of their keys
+	std::vector<int> m_changedPMs; // PMs whose resources changed since the order was last updated
+	std::vector<bool> m_PMChanged; // true for the PMs in m_changedPMs
+	std::vector<unsigned> m_candidateMarks; // PMs marked with the current stamp are candidates of the VM being sorted
+	unsigned m_candidateStamp;
+
+	// forward checking: the free resources of the PMs that are available for some unallocated VM, for each dimension
+	std::vector<int> m_numVMsFitting; // unallocated VMs the PM is available for, for each PM
+	std::vector<long long> m_usableFree; // total free resources of the PMs with m_numVMsFitting > 0
+	int m_numEmptyDomains; // unallocated VMs with no available PM
+	long long m_numDeadEnds; // allocations undone by forward checking
+
+	// PM classes: PMs of the same type with the same free resources are interchangeable, unless they are the initial PM of an unallocated VM
+	// (leaving such a PM costs a migration, these are hashed with their ID instead of their type)
+	std::vector<int> m_PMType; // PMs with the same capacity have the same type
+	std::vector<int> m_numUnallocatedInitialVMs; // for each PM
+	std::vector<uint64_t> m_PMHashes; // hash of the class of each PM
+	uint64_t m_PMsHash; // sum of the hashes of the PMs (with their IDs if the VM chains refer to PM IDs)
+	bool m_hashingPMs; // the hashes are only maintained for symmetry breaking and the nogood cache
+	std::vector<int> m_classSlots; // hash table of the classes of the available PMs of a VM, each slot is a candidate index
+	std::vector<unsigned> m_classSlotStamps; // a slot is used if its stamp is the current one
+	unsigned m_classStamp;
+	std::vector<int> m_classSize; // number of available PMs in the class, for the PM ID of each candidate
+
+	// VM chains: identical VMs (same demand and initial PM) are allocated in the order of their positions, each to a PM with an ID
+	// not less than the PM of the previous one, so that the permutations of their allocations are not searched
+	std::vector<int> m_previousInChain; // position of the previous identical VM, -1 if none
+	std::vector<int> m_nextInChain; // position of the next identical VM, -1 if none
+	std::vector<int> m_numChainEnds; // for each PM: chains whose last allocated VM is on the PM, and which have unallocated VMs
+	uint64_t m_chainEndsHash; // xor of the hashes of the last allocated VMs of the chains and their PMs
+
+	// nogood cache: the key of a state is a hash of the multiset of the PM classes, the unallocated VMs and the migrations
+	NogoodCache m_nogoods;
+	std::vector<uint64_t> m_VMKeys; // random key of each VM (by position)
+	uint64_t m_unallocatedVMsHash; // xor of the keys of the unallocated VMs
+	int m_incompleteDepth; // the nodes of the current branch up to this depth (number of allocated VMs) are not searched completely
+
+	std::vector<int> m_allocatedPM; // current allocations: PM ID for each VM (indexed by position in m_problem.VMs), -1 if unallocated
+	Bitset m_allocated; // positions of the allocated VMs
+	std::vector<int> m_bestAllocatedPM; // best allocation so far, in the same format
+	bool m_hasBestAllocation;
+	DomainSizeQueue m_VMQueue; // unallocated VMs by number of available PMs (only used with failFirst)
+	AllocationMapType m_bestAllocation; // best allocation so far as a map, only built for getBestAllocation()
 	int m_numMaxMigrations;
 	int m_numMigrations;
 	int m_numPMsOn;
@@ -60,24 +142,92 @@ class BnBAllocator : public VMAllocator
 	int m_bestSoFarNumMigrations;
 	int m_bestSoFarNumPMsOn;
 
-	std::stack<VM*> m_VMStack; // stack of allocated VMs
-	std::stack<Change> m_changeStack; // stack of changes during the algorithm
+	std::vector<VM*> m_VMStack; // stack of allocated VMs
+	Trail m_trail; // one level per allocation: positions of the VMs whose available PMs lost the target PM
+	size_t m_rootDepth; // number of allocated VMs at the root of the searched subtree
+
+	// best first search: every created node is kept, an open node is identified by its index
+	struct SearchNode
+	{
+		int parent; // index of the parent node, -1 for the children of the root
+		int VMIndex; // the node is its parent with this VM (by position)...
+		int PMid; // ...allocated to this PM
+	};
+	struct OpenNode
+	{
+		double bound; // minimal total cost in the subtree of the node
+		int depth;
+		int node;
+	};
+	struct OpenNodeComparator // the best node is the one with the smallest bound, then the deepest, then the oldest
+	{
+		bool operator()(const OpenNode& a, const OpenNode& b) const
+		{
+			if (a.bound != b.bound)
+				return a.bound > b.bound;
+			if (a.depth != b.depth)
+				return a.depth < b.depth;
+			return a.node > b.node;
+		}
+	};
+	std::vector<SearchNode> m_nodes;
+	std::priority_queue<OpenNode, std::vector<OpenNode>, OpenNodeComparator> m_openNodes;
+	std::vector<int> m_pathNodes; // nodes of the current allocation, from the root
+	std::vector<int> m_targetPath; // helper of moveToNode()
+	double m_globalLowerBound; // best bound of the open nodes, reported as it improves
+
+	// restarts
+	std::mt19937 m_random; // random tie breaking, only used with restarts
+	long long m_nodesUntilRestart; // depth first search stops when it reaches 0, -1 if there are no restarts
+	int m_numRestarts;
+
+	std::vector<VM*> m_VMById; // VMs indexed by their ID (VMs are sorted in preprocessing)
+	std::vector<int> m_incumbentPMs; // PM ID of each VM ID in the best allocation, only filled for reporting the incumbents
+	std::shared_ptr<const PreprocessedProblem> m_preprocessed; // the input problem shared with the other allocators, also used for creating worker threads and for the warm start
+	WorkPool* m_pool; // shared state of a parallel search, nullptr when this is not a worker
+	bool m_timedOut; // the search stopped before it was complete (timeout or stop request)
+	int m_pollInterval; // nodes between two checks of the timeouts, doubled or halved to keep the checks TIMEOUT_POLL_PERIOD apart
+	int m_nodesUntilPoll;
+	double m_lastPollTime;
+	std::unique_ptr<Tracer> m_tracer; // writes the events of the search threads to the trace file, only owned by the allocator started by the user
+	TraceBuffer* m_trace; // events of this search thread, nullptr if tracing is off
+	std::unique_ptr<PhaseProfiler> m_profiler; // nullptr if not profiling
 
 	std::ofstream& m_log; // output log file
 	Timer m_timer; // timer for creating timestamps
 
 	void preprocess();
+	bool hasToStop();
 	bool isAllocationValid();
 	double computeCost();
 	void allocate(VM* VMHandled, PM* PMCandidate);
 	void deAllocate(VM* VMHandled);
 	bool allVMsAllocated();
 	bool PMsAreTheSame(const PM& pm1, const PM& pm2);
-	bool VMFitsInPM(const VM& vm, const PM& pm);
+
+	// versions specialized for the dimension of resources (D = 1..8), D = 0 is the generic version
+	template<int D> void allocateImpl(VM* VMHandled, PM* PMCandidate);
+	template<int D> void deAllocateImpl(VM* VMHandled);
+	template<int D> bool PMsAreTheSameImpl(const PM& pm1, const PM& pm2);
+	template<int D> bool VMFitsInPM(const VM& vm, const PM& pm);
+	template<int D> void setDimension();
+	void (BnBAllocator::*m_allocateImpl)(VM* VMHandled, PM* PMCandidate);
+	void (BnBAllocator::*m_deAllocateImpl)(VM* VMHandled);
+	bool (BnBAllocator::*m_PMsAreTheSameImpl)(const PM& pm1, const PM& pm2);
 	VM* getNextVM();
+	int indexOf(const VM* vm) { return (int)(vm - m_problem.VMs.data()); }
+	void logCurrentAllocation();
+	void trace(TraceEventType type, int VMid, int PMid, double value) { if (m_trace) m_trace->record(type, VMid, PMid, (int)m_VMStack.size(), value); }
+	void startTracing();
+	void stopTracing();
+	double bestCostValue() final override { return (m_hasBestAllocation) ? m_bestCostSoFar : -1; }
+	void beginPhase(ProfilePhase phase) { if (m_profiler) m_profiler->begin(phase); }
+	void endPhase(ProfilePhase phase) { if (m_profiler) m_profiler->end(phase); }
+	void logProfile();
 
 
 	void initializePMCandidates();
+	void collectCandidates(VM* VMHandled);
 	bool allPossibilitiesExhausted();
 	bool currentBranchExhausted(VM* VMHandled);
 	void resetCandidates(VM* VMHandled);
@@ -86,10 +236,60 @@ class BnBAllocator : public VMAllocator
 	PM* getNextPMCandidate(VM* VMHandled);
 	void setNextPMCandidate(VM* VMHandled);
 	double computeMinimalExtraCost();
+	double searchMinimalExtraCost() { beginPhase(PHASE_BOUND); double cost = computeMinimalExtraCost(); endPhase(PHASE_BOUND); return cost; } // profiled as the bound phase
+	int computeMinimalExtraPMs();
+	void initializeBinPackingBound();
+	void initializeOverloadBound();
+	void initializeForwardChecking();
+	void initializeFitIndex();
+	void initializePMOrder();
+	uint64_t sortKey(PM& pm);
+	void PMChanged(int PMid);
+	void updatePMOrder();
+	void orderCandidates(std::vector<PM*>& pms);
+	bool propagationFailed();
+	void removeMustLeave(PM* pm);
+	void addMustLeave(PM* pm);
+	void initializePMClasses();
+	void initializeVMChains();
+	void newClassStamp();
+	uint64_t stateHash(int PMid, uint64_t hash) { return m_params.VMSymmetryBreaking ? mixHash(hash ^ (uint64_t)PMid) : hash; }
+	uint64_t chainEndHash(int VMIndex, int PMid) { return mixHash(((uint64_t)VMIndex << 32) | (uint32_t)PMid); }
+	void initializeNogoodCache();
+	uint64_t PMHash(const PM& pm);
+	void updatePMHash(const PM& pm);
+	uint64_t stateKey() { return m_PMsHash ^ m_unallocatedVMsHash ^ m_chainEndsHash ^ mixHash((uint64_t)m_numMigrations + 0x9e3779b97f4a7c15ULL); }
+	bool outOfMigrations() { return m_numMigrations + (m_params.overloadBound ? m_numMustLeave : 0) > m_numMaxMigrations; }
+	void updateBestSoFar(double cost);
+	void reportBestSoFar();
+	void warmStart();
+
+	void depthFirstSearch(VM* VMHandled);
+	void bestFirstSearch();
+	void expandCurrentNode(int node, double bound);
+	void moveToNode(int node);
+	size_t bestFirstMemoryUsed();
+	void updateGlobalLowerBound(double bound);
+	void searchWithRestarts();
+	long long restartLimit(int run);
+	void shuffleTies(std::vector<PM*>& pms);
+	void solveInParallel();
+	void work();
+	void searchSubtree(const Subtree& subtree);
+	void donateWork(VM* VMHandled);
+	Subtree getCurrentDecisions();
+
+	BnBAllocator(std::shared_ptr<const PreprocessedProblem> pr, std::shared_ptr<AllocatorParams> pa, std::ofstream& l, WorkPool* pool);
 
 public:
-	BnBAllocator(AllocationProblem pr, std::shared_ptr<AllocatorParams> pa, std::ofstream& l);
+	BnBAllocator(std::shared_ptr<const PreprocessedProblem> pr, std::shared_ptr<AllocatorParams> pa, std::ofstream& l);
 	void solve() final override;
+
+	// installs a known complete allocation as the best solution so far, so that its cost bounds the search from the start
+	// returns false (and changes nothing) if a VM is not allocated, a PM is overloaded or there are too many migrations
+	// a valid allocation that is not better than the best so far is not installed either
+	bool setInitialSolution(const std::vector<int>& PMIdOfVM); // PM ID for each VM ID
+	bool setInitialSolution(const AllocationMapType& allocation); // e.g. the solution of an other allocator for the same problem
 	double getBestCost() final override;
 	const AllocationMapType& getBestAllocation() final override;
 	int getActiveHosts() final override;
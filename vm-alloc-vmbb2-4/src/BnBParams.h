@@ -33,18 +33,52 @@ enum SortType
 	SUM
 };
 
+enum SearchMode
+{
+	DEPTH_FIRST,
+	BEST_FIRST
+};
+
+enum RestartSchedule
+{
+	LUBY,
+	GEOMETRIC
+};
+
 struct BnBParams : public AllocatorParams
 {
 	bool failFirst;
 
 	bool intelligentBound;
+	bool binPackingBound; // bound also with the number of PMs the unallocated VMs need at least (volume and big VMs, for each dimension)
+	bool overloadBound; // bound also with the migrations needed to eliminate the overloads of the initial allocation
+	bool forwardChecking; // backtrack as soon as an unallocated VM has no available PM, or their demand exceeds the free resources of their PMs
 
 	SortType PMSortMethod;
 	SortType VMSortMethod;
 	bool initialPMFirst;
-	bool symmetryBreaking; // causes the loss of optimality
+	bool symmetryBreaking; // only one PM of each class of interchangeable PMs is tried
+	bool VMSymmetryBreaking; // identical VMs (same demand and initial PM) are allocated in order, to PMs with non-decreasing IDs
 
 	double boundThreshold; // bound also when (cost >= bestSoFar * boundThreshold), makes sense when between 0 and 1
+
+	int numThreads; // number of worker threads searching the tree in parallel (1: sequential search)
+
+	int nogoodCacheSize; // MBs for the states proved not to lead to a better solution (for each search thread), 0: no cache
+
+	bool warmStart; // the greedy heuristic is run first, its solution is the initial "best cost so far"
+
+	SearchMode searchMode; // order of exploring the tree in sequential search (the parallel search is always depth first)
+	int bestFirstMemoryLimit; // MBs for the open nodes of best first search, after reaching it the open nodes are searched depth first
+
+	bool restarts; // depth first search is restarted from the root with randomized tie breaking, the best solution is kept
+	RestartSchedule restartSchedule; // number of nodes in the i-th run: restartBase * luby(i) or restartBase * restartFactor^i
+	int restartBase; // at least 1
+	double restartFactor; // greater than 1, otherwise the node limit never grows and the tree is never exhausted
+	unsigned seed; // seed of the random tie breaking
+
+	std::string traceFile; // the events of the search are appended to this binary file (see Trace.h), empty: no tracing
+	bool profile; // time and hardware performance counters of the phases of the allocator (see PhaseProfiler.h), slows down the search
 };
 
 static SortType stringToSortType(const std::string& toConvert)
@@ -72,4 +106,38 @@ static SortType stringToSortType(const std::string& toConvert)
 	}
 }
 
+inline RestartSchedule stringToRestartSchedule(const std::string& toConvert)
+{
+	if (toConvert == "LUBY")
+	{
+		return LUBY;
+	}
+	else if (toConvert == "GEOMETRIC")
+	{
+		return GEOMETRIC;
+	}
+	else
+	{
+		std::cout << "WARNING: Invalid Restart Schedule. Defaulting to LUBY." << std::endl;
+		return LUBY;
+	}
+}
+
+inline SearchMode stringToSearchMode(const std::string& toConvert)
+{
+	if (toConvert == "DEPTH_FIRST")
+	{
+		return DEPTH_FIRST;
+	}
+	else if (toConvert == "BEST_FIRST")
+	{
+		return BEST_FIRST;
+	}
+	else
+	{
+		std::cout << "WARNING: Invalid Search Mode. Defaulting to DEPTH_FIRST." << std::endl;
+		return DEPTH_FIRST;
+	}
+}
+
 #endif
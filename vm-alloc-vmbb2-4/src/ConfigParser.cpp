@@ -6,7 +6,8 @@
 #include "ConfigParser.h"
 
 ConfigParser::ConfigParser(const std::string& path)
-	:m_configFilePath(path)
+	:m_configFilePath(path), showSearchStats(false), CPUTimeout(0), binPackingBound(false), overloadBound(false), forwardChecking(false), VMSymmetryBreaking(false), numThreads(1), nogoodCacheSize(0), warmStart(false), searchMode(DEPTH_FIRST), bestFirstMemoryLimit(256),
+	restarts(false), restartSchedule(LUBY), restartBase(1000), restartFactor(1.5), seed(1), traceFile(""), profile(false)
 {
 
 }
@@ -41,6 +42,11 @@ bool ConfigParser::getShowDetailedCost()
 	return showDetailedCost;
 }
 
+bool ConfigParser::getShowSearchStats()
+{
+	return showSearchStats;
+}
+
 void ConfigParser::parse()
 {
 	std::ifstream configFile(m_configFilePath);
@@ -91,6 +97,10 @@ void ConfigParser::processGeneralParameter(const std::string& key, const std::st
 	{
 		showDetailedCost = stringToBool(value);
 	}
+	else if (key == "showSearchStats")
+	{
+		showSearchStats = stringToBool(value);
+	}
 	else if (key == "numTests")
 	{
 		numTests = std::stoi(value);
@@ -182,6 +192,7 @@ void ConfigParser::processAllocator(std::ifstream& configFile)
 	tempParams->allocatorType = allocatorType;
 	tempParams->name = name;
 	tempParams->timeout = timeout;
+	tempParams->CPUTimeout = CPUTimeout;
 	tempParams->maxMigrationsRatio = maxMigrationsRatio;
 
 
@@ -192,10 +203,26 @@ void ConfigParser::processAllocator(std::ifstream& configFile)
 		bnbParams->boundThreshold = boundThreshold;
 		bnbParams->failFirst = failFirst;
 		bnbParams->intelligentBound = intelligentBound;
+		bnbParams->binPackingBound = binPackingBound;
+		bnbParams->overloadBound = overloadBound;
+		bnbParams->forwardChecking = forwardChecking;
 		bnbParams->VMSortMethod = VMSortMethod;
 		bnbParams->PMSortMethod = PMSortMethod;
 		bnbParams->symmetryBreaking = symmetryBreaking;
+		bnbParams->VMSymmetryBreaking = VMSymmetryBreaking;
 		bnbParams->initialPMFirst = initialPMFirst;
+		bnbParams->numThreads = numThreads;
+		bnbParams->nogoodCacheSize = nogoodCacheSize;
+		bnbParams->warmStart = warmStart;
+		bnbParams->searchMode = searchMode;
+		bnbParams->bestFirstMemoryLimit = bestFirstMemoryLimit;
+		bnbParams->restarts = restarts;
+		bnbParams->restartSchedule = restartSchedule;
+		bnbParams->restartBase = restartBase;
+		bnbParams->restartFactor = restartFactor;
+		bnbParams->seed = seed;
+		bnbParams->traceFile = traceFile;
+		bnbParams->profile = profile;
 	}
 
 	std::shared_ptr<ILPParams> ilpParams = std::dynamic_pointer_cast<ILPParams>(tempParams);
@@ -223,6 +250,10 @@ void ConfigParser::processAllocatorParameter(const std::string& key, const std::
 	{
 		timeout = std::stoi(value);
 	}
+	else if (key == "CPUTimeout")
+	{
+		CPUTimeout = std::stod(value);
+	}
 	else if (key == "solverType")
 	{
 		solverType = stringToSolverType(value);
@@ -247,6 +278,18 @@ void ConfigParser::processAllocatorParameter(const std::string& key, const std::
 	{
 		intelligentBound = stringToBool(value);
 	}
+	else if (key == "binPackingBound")
+	{
+		binPackingBound = stringToBool(value);
+	}
+	else if (key == "overloadBound")
+	{
+		overloadBound = stringToBool(value);
+	}
+	else if (key == "forwardChecking")
+	{
+		forwardChecking = stringToBool(value);
+	}
 	else if (key == "VMSortMethod")
 	{
 		VMSortMethod = stringToSortType(value);
@@ -259,10 +302,72 @@ void ConfigParser::processAllocatorParameter(const std::string& key, const std::
 	{
 		symmetryBreaking = stringToBool(value);
 	}
+	else if (key == "VMSymmetryBreaking")
+	{
+		VMSymmetryBreaking = stringToBool(value);
+	}
 	else if (key == "initialPMFirst")
 	{
 		initialPMFirst = stringToBool(value);
 	}
+	else if (key == "numThreads")
+	{
+		numThreads = std::stoi(value);
+	}
+	else if (key == "nogoodCacheSize")
+	{
+		nogoodCacheSize = std::stoi(value);
+	}
+	else if (key == "warmStart")
+	{
+		warmStart = stringToBool(value);
+	}
+	else if (key == "searchMode")
+	{
+		searchMode = stringToSearchMode(value);
+	}
+	else if (key == "bestFirstMemoryLimit")
+	{
+		bestFirstMemoryLimit = std::stoi(value);
+	}
+	else if (key == "restarts")
+	{
+		restarts = stringToBool(value);
+	}
+	else if (key == "restartSchedule")
+	{
+		restartSchedule = stringToRestartSchedule(value);
+	}
+	else if (key == "restartBase")
+	{
+		restartBase = std::stoi(value);
+		if (restartBase < 1)
+		{
+			std::cout << "Invalid restartBase in config file, must be at least 1: " << value << std::endl;
+			exit(1);
+		}
+	}
+	else if (key == "restartFactor")
+	{
+		restartFactor = std::stod(value);
+		if (!(restartFactor > 1))
+		{
+			std::cout << "Invalid restartFactor in config file, must be greater than 1: " << value << std::endl;
+			exit(1);
+		}
+	}
+	else if (key == "seed")
+	{
+		seed = (unsigned)std::stoul(value);
+	}
+	else if (key == "traceFile")
+	{
+		traceFile = (value == "none") ? "" : value;
+	}
+	else if (key == "profile")
+	{
+		profile = stringToBool(value);
+	}
 }
 
 bool ConfigParser::stringToBool(const std::string& toConvert)
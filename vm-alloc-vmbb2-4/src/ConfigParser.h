@@ -44,6 +44,7 @@ private:
 	std::string m_configFilePath;
 
 	bool showDetailedCost;
+	bool showSearchStats; // counters of the search as additional columns of the results (see SearchStats)
 	int numTests;
 
 	// generator parameters
@@ -60,6 +61,7 @@ private:
 	AllocatorType allocatorType;
 	std::string name;
 	double timeout;
+	double CPUTimeout;
 
 	// ILP only
 	SolverType solverType;
@@ -70,10 +72,26 @@ private:
 	int maxMigrationsRatio;
 	bool failFirst;
 	bool intelligentBound;
+	bool binPackingBound;
+	bool overloadBound;
+	bool forwardChecking;
 	SortType VMSortMethod;
 	SortType PMSortMethod;
 	bool symmetryBreaking;
+	bool VMSymmetryBreaking;
 	bool initialPMFirst;
+	int numThreads;
+	int nogoodCacheSize;
+	bool warmStart;
+	SearchMode searchMode;
+	int bestFirstMemoryLimit;
+	bool restarts;
+	RestartSchedule restartSchedule;
+	int restartBase;
+	double restartFactor;
+	unsigned seed;
+	std::string traceFile;
+	bool profile;
 
 	// helpers
 	std::unique_ptr<ProblemGenerator> m_generator;
@@ -93,6 +111,7 @@ public:
 	Steps getVMs();
 	Steps getPMs();
 	bool getShowDetailedCost();
+	bool getShowSearchStats();
 };
 
 #endif
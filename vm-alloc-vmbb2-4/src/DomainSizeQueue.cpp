@@ -0,0 +1,110 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cassert>
+
+#include "DomainSizeQueue.h"
+
+DomainSizeQueue::DomainSizeQueue(int numVMs, int maxSize)
+	:m_first(maxSize + 1, -1), m_bucketSize(maxSize + 1, 0), m_next(numVMs, -1), m_prev(numVMs, -1), m_sizeOf(numVMs, -1), m_minSize(maxSize + 1), m_numElements(0)
+{
+
+}
+
+// links a VM at the front of a bucket
+void DomainSizeQueue::link(int vm, int size)
+{
+	int first = m_first[size];
+	m_prev[vm] = -1;
+	m_next[vm] = first;
+	if (first != -1)
+		m_prev[first] = vm;
+	m_first[size] = vm;
+	++m_bucketSize[size];
+	m_sizeOf[vm] = size;
+	if (size < m_minSize)
+		m_minSize = size;
+}
+
+void DomainSizeQueue::unlink(int vm)
+{
+	int size = m_sizeOf[vm];
+	if (m_prev[vm] != -1)
+		m_next[m_prev[vm]] = m_next[vm];
+	else
+		m_first[size] = m_next[vm];
+	if (m_next[vm] != -1)
+		m_prev[m_next[vm]] = m_prev[vm];
+	--m_bucketSize[size];
+	m_sizeOf[vm] = -1;
+}
+
+void DomainSizeQueue::insert(int vm, int size)
+{
+	assert(!contains(vm));
+	link(vm, size);
+	++m_numElements;
+}
+
+void DomainSizeQueue::remove(int vm)
+{
+	assert(contains(vm));
+	unlink(vm);
+	--m_numElements;
+}
+
+// moves a VM to another bucket, called when its domain changes
+void DomainSizeQueue::update(int vm, int size)
+{
+	assert(contains(vm));
+	unlink(vm);
+	link(vm, size);
+}
+
+// returns the VM with the smallest domain (the first one in its bucket)
+// the minimum only moves up here, and domains change by one at a time, so this is O(1) amortized
+int DomainSizeQueue::top()
+{
+	assert(!empty());
+	while (m_first[m_minSize] == -1)
+	{
+		++m_minSize;
+	}
+	return m_first[m_minSize];
+}
+
+// returns the VM of the given rank (from 0) among the ones with the smallest domain, in the order of the bucket
+// used for breaking ties randomly: with a uniform rank every VM of the bucket is equally likely, O(rank)
+int DomainSizeQueue::top(int rank)
+{
+	assert(rank >= 0 && rank < numTop());
+	int vm = top();
+	while (rank-- > 0)
+	{
+		vm = m_next[vm];
+	}
+	return vm;
+}
+
+// returns the number of VMs with the smallest domain
+int DomainSizeQueue::numTop()
+{
+	top(); // moves the minimum up to the first non-empty bucket
+	return m_bucketSize[m_minSize];
+}
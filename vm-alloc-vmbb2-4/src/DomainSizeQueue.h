@@ -0,0 +1,56 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DOMAINSIZEQUEUE_H
+#define DOMAINSIZEQUEUE_H
+
+#include <vector>
+
+// bucket priority queue of VMs (given by their position) keyed by the size of their domain
+// each bucket is an intrusive doubly linked list, so moving a VM between buckets is O(1), and the memory is O(numVMs + maxSize)
+// ties are broken by the order in the bucket: a VM entering a bucket is linked at its front, so the VM constrained last comes first
+// (the buckets are filled in sorted order at the start, so among the VMs that have not moved the order of the VMs decides)
+class DomainSizeQueue
+{
+	std::vector<int> m_first; // first VM of each bucket, -1 if the bucket is empty
+	std::vector<int> m_bucketSize; // number of VMs in each bucket
+	std::vector<int> m_next; // next VM in the bucket of each VM, -1 at the end
+	std::vector<int> m_prev; // previous VM in the bucket of each VM, -1 at the front
+	std::vector<int> m_sizeOf; // current key of each VM, -1 if not in the queue
+	int m_minSize; // no bucket below this is non-empty
+	int m_numElements;
+
+	void link(int vm, int size);
+	void unlink(int vm);
+
+public:
+	DomainSizeQueue() :m_minSize(0), m_numElements(0) {}
+	DomainSizeQueue(int numVMs, int maxSize);
+
+	void insert(int vm, int size);
+	void remove(int vm);
+	void update(int vm, int size);
+	int top();
+	int top(int rank);
+	int numTop();
+	bool contains(int vm) const { return m_sizeOf[vm] != -1; }
+	bool empty() const { return m_numElements == 0; }
+};
+
+#endif
@@ -1,9 +1,10 @@
 #include <algorithm>
 #include "GreedyAllocator.h"
+#include "Timer.h"
 
 
-GreedyAllocator::GreedyAllocator(AllocationProblem pr, std::shared_ptr<AllocatorParams> pa, std::ofstream& l)
-	:m_problem(pr), m_log(l)
+GreedyAllocator::GreedyAllocator(std::shared_ptr<const PreprocessedProblem> pr, std::shared_ptr<AllocatorParams> pa, std::ofstream& l)
+	:m_problem(pr->getProblem()), m_log(l)
 {
 	m_numVMs = m_problem.VMs.size();
 	m_numPMs = m_problem.PMs.size();
@@ -107,6 +108,9 @@ void GreedyAllocator::solve()
 	//std::vector<VM*> vms(m_problem.VMs);
 	//std::sort(vms.begin(),vms.end(),vm_less);
 	//std::vector<VM*> vms_to_migrate;
+	resetStats();
+	Timer timer;
+	timer.start();
 	m_numMigrations=0;
 	//relieve overloaded hosts
 	for(auto& pm : m_problem.PMs)
@@ -175,6 +179,23 @@ void GreedyAllocator::solve()
 			m_bestAllocation[vm]=pm;
 		}
 	}
+	//the result is the only incumbent, if no PM is left overloaded
+	bool valid=true;
+	for(auto& pm : m_problem.PMs)
+		for(int k=0;k<m_dimension;k++)
+			if(m_load_of_pms[&pm][k]>pm.capacity[k])
+				valid=false;
+	if(valid)
+	{
+		recordIncumbentTime(timer.getElapsedTime());
+		if(reportsIncumbents())
+		{
+			std::vector<int> pm_of_vm(m_numVMs,-1);
+			for(auto& entry : m_bestAllocation)
+				pm_of_vm[entry.first->id]=entry.second->id;
+			reportIncumbent(m_bestCost,m_numPMsOn,m_numMigrations,m_stats.timeToBestIncumbent,pm_of_vm);
+		}
+	}
 }
 
 
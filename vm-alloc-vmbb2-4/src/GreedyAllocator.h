@@ -6,6 +6,7 @@
 #include <memory>
 #include "VMAllocator.h"
 #include "AllocatorParams.h"
+#include "PreprocessedProblem.h"
 
 class GreedyAllocator: public VMAllocator
 {
@@ -26,10 +27,11 @@ private:
 	std::map<PM*,std::vector<int>> m_load_of_pms;
 	bool pm_less_guazz(PM *a, PM *b);
 	bool pm_less_numvm(PM *a, PM *b);
+	bool vm_less(VM *a, VM *b);
 	PM * find_pm_for_vm(VM * vm);
 	void migrate(VM * vm, PM * pm1, PM * pm2);
 public:
-	GreedyAllocator(AllocationProblem pr, std::shared_ptr<AllocatorParams> pa, std::ofstream& l);
+	GreedyAllocator(std::shared_ptr<const PreprocessedProblem> pr, std::shared_ptr<AllocatorParams> pa, std::ofstream& l);
 	void solve() final override;
 	double getBestCost() final override;
 	const AllocationMapType& getBestAllocation() final override;
@@ -27,8 +27,8 @@ using std::ofstream;
 using std::ifstream;
 using std::endl;
 
-ILPAllocator::ILPAllocator(AllocationProblem pr, std::shared_ptr<AllocatorParams> pa, std::ofstream& l)
-	:m_problem(pr), m_log(l)
+ILPAllocator::ILPAllocator(std::shared_ptr<const PreprocessedProblem> pr, std::shared_ptr<AllocatorParams> pa, std::ofstream& l)
+	:m_problem(pr->getProblem()), m_log(l)
 {
 	std::shared_ptr<ILPParams> params = std::dynamic_pointer_cast<ILPParams>(pa);
 
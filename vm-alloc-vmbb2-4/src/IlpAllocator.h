@@ -25,6 +25,7 @@ along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
 
 #include "VMAllocator.h"
 #include "AllocationProblem.h"
+#include "PreprocessedProblem.h"
 #include "AllocatorParams.h"
 #include "ILPParams.h"
 
@@ -45,7 +46,7 @@ class ILPAllocator : public VMAllocator
 	void create_lp(char *filename);
 
 public:
-	ILPAllocator(AllocationProblem pr, std::shared_ptr<AllocatorParams> pa, std::ofstream& l);
+	ILPAllocator(std::shared_ptr<const PreprocessedProblem> pr, std::shared_ptr<AllocatorParams> pa, std::ofstream& l);
 	void solve() final override;
 	double getBestCost() final override;
 	const AllocationMapType& getBestAllocation() final override;
@@ -0,0 +1,42 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "NogoodCache.h"
+
+// the number of slots is the largest power of two fitting into the given size
+NogoodCache::NogoodCache(int megabytes)
+	:m_mask(0), m_numLookups(0), m_numHits(0), m_numStored(0)
+{
+	if (megabytes <= 0)
+		return;
+
+	size_t numSlots = 1;
+	while (numSlots * 2 * sizeof(uint64_t) <= (size_t)megabytes * 1024 * 1024)
+		numSlots *= 2;
+	m_keys.assign(numSlots, 0);
+	m_mask = numSlots - 1;
+}
+
+// adds the counters of an other cache (e.g. of a worker thread)
+void NogoodCache::addStatistics(const NogoodCache& other)
+{
+	m_numLookups += other.m_numLookups;
+	m_numHits += other.m_numHits;
+	m_numStored += other.m_numStored;
+}
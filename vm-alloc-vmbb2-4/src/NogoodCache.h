@@ -0,0 +1,81 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NOGOODCACHE_H
+#define NOGOODCACHE_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// mixes the bits of a 64 bit value (finalizer of splitmix64), used for hashing search states
+inline uint64_t mixHash(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return x;
+}
+
+// fixed size hash table of the keys of search states whose subtree was exhausted without finding a better solution
+// reaching such a state again (with the same cost so far) cannot lead to a better solution either
+// one key per slot, a new key overwrites the old one in its slot
+class NogoodCache
+{
+	std::vector<uint64_t> m_keys; // 0: empty slot
+	uint64_t m_mask;
+
+	long long m_numLookups;
+	long long m_numHits;
+	long long m_numStored;
+
+	static uint64_t nonZero(uint64_t key) { return key != 0 ? key : 1; }
+
+public:
+	NogoodCache() :m_mask(0), m_numLookups(0), m_numHits(0), m_numStored(0) {}
+	explicit NogoodCache(int megabytes);
+
+	bool enabled() const { return !m_keys.empty(); }
+
+	bool contains(uint64_t key)
+	{
+		++m_numLookups;
+		key = nonZero(key);
+		if (m_keys[key & m_mask] != key)
+			return false;
+		++m_numHits;
+		return true;
+	}
+
+	void insert(uint64_t key)
+	{
+		++m_numStored;
+		key = nonZero(key);
+		m_keys[key & m_mask] = key;
+	}
+
+	void addStatistics(const NogoodCache& other);
+	long long getNumLookups() const { return m_numLookups; }
+	long long getNumHits() const { return m_numHits; }
+	long long getNumStored() const { return m_numStored; }
+};
+
+#endif
@@ -59,16 +59,8 @@ bool MaximumPMComparator(PM* first, PM* second)
 	if (secondIsOn && !firstIsOn)
 		return false;
 
-	int firstMax  = 0;
-	int secondMax = 0;
-	for (std::size_t i = 0; i < first->resourcesFree.size(); i++)
-	{
-		if (first->resourcesFree[i] > firstMax)
-			firstMax = first->resourcesFree[i];
-
-		if (second->resourcesFree[i] > secondMax)
-			secondMax = second->resourcesFree[i];
-	}
+	int firstMax = first->maxFree;
+	int secondMax = second->maxFree;
 
 	if (firstIsOn && secondIsOn)
 		return firstMax < secondMax;
@@ -88,13 +80,8 @@ bool SumPMComparator(PM* first, PM* second)
 	if (secondIsOn && !firstIsOn)
 		return false;
 
-	int firstSum = 0;
-	int secondSum = 0;
-	for (std::size_t i = 0; i < first->resourcesFree.size(); i++)
-	{
-		firstSum += first->resourcesFree[i];
-		secondSum += second->resourcesFree[i];
-	}
+	int firstSum = first->sumFree;
+	int secondSum = second->sumFree;
 
 	if (firstIsOn && secondIsOn)
 		return firstSum < secondSum;
@@ -106,15 +93,20 @@ bool SumPMComparator(PM* first, PM* second)
 PM::PM()
 {
 	numAdditionalVMs = 0;
+	numVMs = 0;
+	sumFree = 0;
+	maxFree = 0;
 }
 
-bool PM::isOn()
+// recomputes the aggregates of the free resources, called after resourcesFree changes
+void PM::updateFree()
 {
+	sumFree = 0;
+	maxFree = 0;
 	for (std::size_t i = 0; i < resourcesFree.size(); i++)
 	{
-		if (resourcesFree[i] != capacity[i])
-			return true;
+		sumFree += resourcesFree[i];
+		if (resourcesFree[i] > maxFree)
+			maxFree = resourcesFree[i];
 	}
-
-	return false;
 }
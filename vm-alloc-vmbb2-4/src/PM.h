@@ -28,8 +28,12 @@ struct PM
 	int numAdditionalVMs; // number of additional VMs allocated on this PM, if we now leave all VMs on their initial PM
 	std::vector<int> capacity;
 	std::vector<int> resourcesFree;
+	int numVMs; // number of VMs allocated on this PM
+	int sumFree; // sum of resourcesFree, kept up to date by updateFree()
+	int maxFree; // maximum of resourcesFree, kept up to date by updateFree()
 
-	bool isOn();
+	bool isOn() const { return numVMs > 0; }
+	void updateFree();
 	PM();
 };
 
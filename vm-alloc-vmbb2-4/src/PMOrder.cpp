@@ -0,0 +1,52 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include "PMOrder.h"
+
+PMOrder::PMOrder(const std::vector<uint64_t>& keys)
+	:m_keys(keys), m_order(keys.size())
+{
+	for (size_t pm = 0; pm < keys.size(); pm++)
+		m_order[pm] = { keys[pm], (int)pm };
+	std::sort(m_order.begin(), m_order.end());
+}
+
+// the entry is found and its new place is searched by bisection, the entries in between are moved by one
+void PMOrder::update(int pm, uint64_t key)
+{
+	Entry oldEntry = { m_keys[pm], pm };
+	Entry newEntry = { key, pm };
+	m_keys[pm] = key;
+
+	auto current = std::lower_bound(m_order.begin(), m_order.end(), oldEntry);
+	if (newEntry < oldEntry)
+	{
+		auto target = std::lower_bound(m_order.begin(), current, newEntry);
+		std::move_backward(target, current, current + 1);
+		*target = newEntry;
+	}
+	else
+	{
+		auto target = std::lower_bound(current + 1, m_order.end(), newEntry);
+		std::move(current + 1, target, current);
+		*(target - 1) = newEntry;
+	}
+}
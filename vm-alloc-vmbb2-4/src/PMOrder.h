@@ -0,0 +1,52 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PMORDER_H
+#define PMORDER_H
+
+#include <vector>
+#include <cstdint>
+
+// PMs (given by their ID) in ascending order of their sort keys, ties are broken by ID
+// a PM is moved to its new place when its key changes, so the order is never sorted again
+class PMOrder
+{
+public:
+	struct Entry
+	{
+		uint64_t key;
+		int pm;
+		bool operator<(const Entry& other) const { return key < other.key || (key == other.key && pm < other.pm); }
+	};
+
+private:
+	std::vector<uint64_t> m_keys; // current key of each PM
+	std::vector<Entry> m_order; // sorted entries of every PM
+
+public:
+	PMOrder() {}
+	explicit PMOrder(const std::vector<uint64_t>& keys);
+
+	void update(int pm, uint64_t key);
+	uint64_t key(int pm) const { return m_keys[pm]; }
+	bool less(int pm1, int pm2) const { return Entry{ m_keys[pm1], pm1 } < Entry{ m_keys[pm2], pm2 }; }
+	const std::vector<Entry>& order() const { return m_order; }
+};
+
+#endif
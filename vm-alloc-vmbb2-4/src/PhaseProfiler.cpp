@@ -0,0 +1,155 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+
+#ifdef __linux__
+	#include <unistd.h>
+	#include <sys/ioctl.h>
+	#include <sys/syscall.h>
+	#include <linux/perf_event.h>
+#endif
+
+#include "PhaseProfiler.h"
+
+#ifdef __linux__
+// opens a hardware counter of the calling thread (user space only), in the group of groupFd (-1: as the leader of a new group)
+static int openCounter(uint64_t config, int groupFd)
+{
+	perf_event_attr attr;
+	std::memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = config;
+	attr.disabled = (groupFd == -1) ? 1 : 0; // the group is enabled at once, after every counter is open
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP;
+	return (int)syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+#endif
+
+PhaseProfiler::PhaseProfiler()
+	:m_groupFd(-1), m_countersAvailable(true), m_phases(NUM_PROFILE_PHASES)
+{
+	for (auto& fd : m_fds)
+		fd = -1;
+	for (auto& phase : m_phases)
+		for (auto& counter : phase.counters)
+			counter = -1; // until the counters are opened
+}
+
+PhaseProfiler::~PhaseProfiler()
+{
+	closeCounters();
+}
+
+void PhaseProfiler::openCounters()
+{
+	if (hasCounters() && m_thread == std::this_thread::get_id())
+		return;
+	closeCounters();
+	if (!m_countersAvailable)
+		return;
+
+	#ifdef __linux__
+		const uint64_t configs[NUM_PROFILE_COUNTERS] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+		for (int c = 0; c < NUM_PROFILE_COUNTERS; c++)
+		{
+			m_fds[c] = openCounter(configs[c], m_groupFd);
+			if (m_fds[c] == -1) // all or nothing, so that the counters of a phase are comparable
+			{
+				closeCounters();
+				m_countersAvailable = false;
+				return;
+			}
+			if (c == 0)
+				m_groupFd = m_fds[0];
+		}
+		ioctl(m_groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		m_thread = std::this_thread::get_id();
+
+		for (auto& phase : m_phases)
+			for (auto& counter : phase.counters)
+				if (counter < 0)
+					counter = 0;
+	#else
+		m_countersAvailable = false;
+	#endif
+}
+
+void PhaseProfiler::closeCounters()
+{
+	#ifdef __linux__
+		for (auto& fd : m_fds)
+		{
+			if (fd != -1)
+				close(fd);
+			fd = -1;
+		}
+	#endif
+	m_groupFd = -1;
+}
+
+void PhaseProfiler::takeSnapshot(Snapshot& snapshot)
+{
+	snapshot.time = std::chrono::steady_clock::now();
+	#ifdef __linux__
+		if (hasCounters())
+		{
+			uint64_t values[1 + NUM_PROFILE_COUNTERS]; // number of counters, then their values in the order of opening
+			if (read(m_groupFd, values, sizeof(values)) == (ssize_t)sizeof(values))
+				std::memcpy(snapshot.counters, values + 1, sizeof(snapshot.counters));
+		}
+	#endif
+}
+
+void PhaseProfiler::end(ProfilePhase phase)
+{
+	Snapshot now;
+	takeSnapshot(now);
+
+	PhaseProfile& profile = m_phases[phase];
+	const Snapshot& start = m_start[phase];
+	profile.time += std::chrono::duration<double>(now.time - start.time).count();
+	if (hasCounters())
+	{
+		for (int c = 0; c < NUM_PROFILE_COUNTERS; c++)
+			profile.counters[c] += (long long)(now.counters[c] - start.counters[c]);
+	}
+}
+
+void PhaseProfiler::add(const PhaseProfiler& other)
+{
+	for (int p = 0; p < NUM_PROFILE_PHASES; p++)
+	{
+		PhaseProfile& profile = m_phases[p];
+		const PhaseProfile& otherProfile = other.m_phases[p];
+		profile.calls += otherProfile.calls;
+		profile.workerTime += otherProfile.time + otherProfile.workerTime;
+		for (int c = 0; c < NUM_PROFILE_COUNTERS; c++)
+		{
+			if (otherProfile.counters[c] < 0)
+				continue;
+			if (profile.counters[c] < 0)
+				profile.counters[c] = 0;
+			profile.counters[c] += otherProfile.counters[c];
+		}
+	}
+}
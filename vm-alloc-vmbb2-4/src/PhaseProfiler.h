@@ -0,0 +1,105 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PHASEPROFILER_H
+#define PHASEPROFILER_H
+
+#include <cstdint>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+// phases of BnBAllocator, a phase includes the phases nested into it (fit matrix in preprocessing, bound and incumbent in search)
+enum ProfilePhase
+{
+	PHASE_PREPROCESS, // initialization of the search state in the constructor
+	PHASE_FIT_MATRIX, // resource matrix, available PMs and fit index
+	PHASE_SEARCH, // the search itself (sequential or parallel, with the warm start)
+	PHASE_BOUND, // lower bounds of the partial allocations
+	PHASE_INCUMBENT, // saving a new best allocation
+	NUM_PROFILE_PHASES
+};
+
+enum ProfileCounter
+{
+	COUNTER_CYCLES,
+	COUNTER_INSTRUCTIONS,
+	COUNTER_CACHE_MISSES,
+	COUNTER_BRANCH_MISSES,
+	NUM_PROFILE_COUNTERS
+};
+
+inline const char* profilePhaseName(int phase)
+{
+	static const char* names[] = { "preprocess", "fit matrix", "search", "bound", "incumbent" };
+	return names[phase];
+}
+
+inline const char* profileCounterName(int counter)
+{
+	static const char* names[] = { "cycles", "instructions", "cache misses", "branch misses" };
+	return names[counter];
+}
+
+// totals of one phase
+struct PhaseProfile
+{
+	long long calls = 0;
+	double time = 0; // seconds (wall-clock) on the thread of solve(), a parallel search is measured once
+	double workerTime = 0; // seconds summed over the worker threads of a parallel search, not included in time
+	long long counters[NUM_PROFILE_COUNTERS] = {}; // user space events of the profiled threads, -1 if the hardware counters are not available
+};
+
+// measures the time and the hardware performance counters (Linux perf events) of the phases
+// the counters are only read on the thread that opened them, without them (other OS, no permission, no PMU) only the time is measured
+class PhaseProfiler
+{
+	struct Snapshot
+	{
+		std::chrono::steady_clock::time_point time;
+		uint64_t counters[NUM_PROFILE_COUNTERS];
+	};
+
+	int m_groupFd; // leader of the group of counters (cycles), -1 if the counters are not open
+	int m_fds[NUM_PROFILE_COUNTERS];
+	bool m_countersAvailable; // false after the counters could not be opened once
+	std::thread::id m_thread; // the counters count the events of this thread
+	std::vector<PhaseProfile> m_phases;
+	Snapshot m_start[NUM_PROFILE_PHASES];
+
+	void takeSnapshot(Snapshot& snapshot);
+	void closeCounters();
+
+public:
+	PhaseProfiler();
+	~PhaseProfiler();
+	PhaseProfiler(const PhaseProfiler&) = delete;
+	PhaseProfiler& operator=(const PhaseProfiler&) = delete;
+
+	void openCounters(); // counts the events of the calling thread from now on, no phase may be running
+	bool hasCounters() { return m_groupFd != -1; }
+
+	void begin(ProfilePhase phase) { ++m_phases[phase].calls; takeSnapshot(m_start[phase]); }
+	void end(ProfilePhase phase);
+
+	void add(const PhaseProfiler& other); // adds the totals of a worker thread, its time goes to the worker time
+	const std::vector<PhaseProfile>& getPhases() const { return m_phases; } // indexed by ProfilePhase
+};
+
+#endif
\ No newline at end of file
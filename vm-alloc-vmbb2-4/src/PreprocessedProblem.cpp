@@ -0,0 +1,74 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <map>
+#include <cassert>
+
+#include "PreprocessedProblem.h"
+#include "ResourceMatrix.h"
+
+PreprocessedProblem::PreprocessedProblem(const AllocationProblem& problem)
+	:m_problem(problem), m_numPMTypes(0), m_numVMClasses(0)
+{
+	int numVMs = m_problem.VMs.size();
+	int numPMs = m_problem.PMs.size();
+	m_dimension = m_problem.VMs[0].demand.size(); // only works if all VMs have the same number of dimensions
+	for (int vm = 0; vm < numVMs; vm++)
+		assert(m_problem.VMs[vm].id == vm);
+	for (int pm = 0; pm < numPMs; pm++)
+		assert(m_problem.PMs[pm].id == pm);
+
+	// fit checks of the empty PMs, with the vectorized kernels
+	ResourceMatrix resources(m_problem.VMs, m_problem.PMs, m_dimension);
+	m_fittingPMs.resize(numVMs);
+	for (int vm = 0; vm < numVMs; vm++)
+	{
+		m_fittingPMs[vm] = Bitset(numPMs);
+		resources.fittingPMs(vm, m_fittingPMs[vm].words().data());
+		m_fittingPMs[vm].recount();
+	}
+
+	std::vector<std::vector<int>> capacities; // capacity of each PM type
+	m_PMType.resize(numPMs);
+	for (int pm = 0; pm < numPMs; pm++)
+	{
+		auto type = std::find(capacities.begin(), capacities.end(), m_problem.PMs[pm].capacity);
+		m_PMType[pm] = (int)(type - capacities.begin());
+		if (type == capacities.end())
+			capacities.push_back(m_problem.PMs[pm].capacity);
+	}
+	m_numPMTypes = capacities.size();
+
+	std::map<std::pair<std::vector<int>, int>, int> classes; // class of each demand and initial PM
+	m_VMClass.resize(numVMs);
+	for (int vm = 0; vm < numVMs; vm++)
+	{
+		auto VMClass = classes.insert(std::make_pair(std::make_pair(m_problem.VMs[vm].demand, m_problem.VMs[vm].initialID), (int)classes.size()));
+		m_VMClass[vm] = VMClass.first->second;
+	}
+	m_numVMClasses = classes.size();
+
+	m_numInitialVMs.assign(numPMs, 0);
+	for (const VM& vm : m_problem.VMs)
+	{
+		if (vm.initialID != -1)
+			++m_numInitialVMs[vm.initialID];
+	}
+}
@@ -0,0 +1,54 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PREPROCESSEDPROBLEM_H
+#define PREPROCESSEDPROBLEM_H
+
+#include <vector>
+
+#include "AllocationProblem.h"
+#include "Bitset.h"
+
+// the data of an allocation problem that does not depend on the parameters of the allocators
+// it is computed once for each instance and shared (read-only) by every allocator solving it and by their worker threads
+class PreprocessedProblem
+{
+	AllocationProblem m_problem; // the input problem, VMs and PMs are indexed by their IDs
+	int m_dimension; // dimension of resources
+	std::vector<Bitset> m_fittingPMs; // PMs each VM fits in when every PM is empty, i.e. the initial domains
+	std::vector<int> m_PMType; // PMs with the same capacity have the same type
+	int m_numPMTypes;
+	std::vector<int> m_VMClass; // VMs with the same demand and initial PM are in the same class
+	int m_numVMClasses;
+	std::vector<int> m_numInitialVMs; // number of VMs on each PM in the initial allocation
+
+public:
+	explicit PreprocessedProblem(const AllocationProblem& problem);
+
+	const AllocationProblem& getProblem() const { return m_problem; }
+	int getDimension() const { return m_dimension; }
+	const Bitset& getFittingPMs(int VMid) const { return m_fittingPMs[VMid]; }
+	const std::vector<int>& getPMTypes() const { return m_PMType; }
+	int getNumPMTypes() const { return m_numPMTypes; }
+	int getVMClass(int VMid) const { return m_VMClass[VMid]; }
+	int getNumVMClasses() const { return m_numVMClasses; }
+	int getNumInitialVMs(int PMid) const { return m_numInitialVMs[PMid]; }
+};
+
+#endif
\ No newline at end of file
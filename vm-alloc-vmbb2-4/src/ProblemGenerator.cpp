@@ -80,6 +80,7 @@ AllocationProblem ProblemGenerator::generate()
 			pm.capacity.push_back(cap);
 			pm.resourcesFree.push_back(cap);
 		}
+		pm.updateFree();
 
 		PMTypes.push_back(pm);
 	}
@@ -179,6 +180,7 @@ AllocationProblem ProblemGenerator::testFromFile(std::string path)
 			pm.capacity.push_back(buffer);
 			pm.resourcesFree.push_back(buffer);
 		}
+		pm.updateFree();
 
 		pm.id = i;
 		PMs.push_back(pm);
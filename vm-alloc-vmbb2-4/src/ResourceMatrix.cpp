@@ -0,0 +1,221 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <climits>
+#include <cstring>
+
+#include "ResourceMatrix.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define RESOURCEMATRIX_X86_KERNELS
+	#include <immintrin.h>
+#endif
+
+namespace
+{
+	const int BLOCK = 8; // elements tested at once, rows are padded to this
+	const size_t ALIGNMENT = 32; // bytes
+
+	int roundUp(int n)
+	{
+		return (n + BLOCK - 1) / BLOCK * BLOCK;
+	}
+
+	// offset (in ints) from the start of the storage to the first aligned element
+	size_t alignedOffset(const std::vector<int>& storage)
+	{
+		uintptr_t address = (uintptr_t)storage.data();
+		return ((ALIGNMENT - address % ALIGNMENT) % ALIGNMENT) / sizeof(int);
+	}
+
+	// writes 8 bits of a mask into a bitset, position must be a multiple of 8
+	inline void storeByte(uint64_t* result, int position, unsigned bits)
+	{
+		reinterpret_cast<unsigned char*>(result)[position / 8] = (unsigned char)bits; // bitsets are little-endian on x86
+	}
+
+	// the kernels test a block of elements of the rows against one limit per dimension
+	// rowsAtLeastLimits: bit i is set if rows[d][i] >= limits[d] in every dimension (PMs' free resources against a VM's demand)
+	// otherwise: bit i is set if rows[d][i] <= limits[d] in every dimension (VMs' demands against a PM's free resources)
+	// D is the dimension if known at compile time, 0 otherwise
+
+	template<int D>
+	void scalarKernel(const int* const* rows, const int* limits, int dimension, int paddedLength, bool rowsAtLeastLimits, uint64_t* result)
+	{
+		std::memset(result, 0, ((paddedLength + 63) / 64) * sizeof(uint64_t));
+		for (int i = 0; i < paddedLength; i++)
+		{
+			bool ok = true;
+			for (int d = 0; d < dimensionOf<D>(dimension) && ok; d++)
+			{
+				ok = rowsAtLeastLimits ? (rows[d][i] >= limits[d]) : (rows[d][i] <= limits[d]);
+			}
+			if (ok)
+				result[i / 64] |= uint64_t(1) << (i % 64);
+		}
+	}
+
+#ifdef RESOURCEMATRIX_X86_KERNELS
+	template<int D>
+	__attribute__((target("sse2")))
+	void sse2Kernel(const int* const* rows, const int* limits, int dimension, int paddedLength, bool rowsAtLeastLimits, uint64_t* result)
+	{
+		for (int i = 0; i < paddedLength; i += BLOCK)
+		{
+			__m128i failLow = _mm_setzero_si128();
+			__m128i failHigh = _mm_setzero_si128();
+			for (int d = 0; d < dimensionOf<D>(dimension); d++)
+			{
+				__m128i limit = _mm_set1_epi32(limits[d]);
+				__m128i low = _mm_load_si128(reinterpret_cast<const __m128i*>(rows[d] + i));
+				__m128i high = _mm_load_si128(reinterpret_cast<const __m128i*>(rows[d] + i + 4));
+				if (rowsAtLeastLimits) // fails if limit > value
+				{
+					failLow = _mm_or_si128(failLow, _mm_cmpgt_epi32(limit, low));
+					failHigh = _mm_or_si128(failHigh, _mm_cmpgt_epi32(limit, high));
+				}
+				else // fails if value > limit
+				{
+					failLow = _mm_or_si128(failLow, _mm_cmpgt_epi32(low, limit));
+					failHigh = _mm_or_si128(failHigh, _mm_cmpgt_epi32(high, limit));
+				}
+			}
+			unsigned fail = _mm_movemask_ps(_mm_castsi128_ps(failLow)) | (_mm_movemask_ps(_mm_castsi128_ps(failHigh)) << 4);
+			storeByte(result, i, ~fail & 0xFF);
+		}
+	}
+
+	template<int D>
+	__attribute__((target("avx2")))
+	void avx2Kernel(const int* const* rows, const int* limits, int dimension, int paddedLength, bool rowsAtLeastLimits, uint64_t* result)
+	{
+		for (int i = 0; i < paddedLength; i += BLOCK)
+		{
+			__m256i fail = _mm256_setzero_si256();
+			for (int d = 0; d < dimensionOf<D>(dimension); d++)
+			{
+				__m256i limit = _mm256_set1_epi32(limits[d]);
+				__m256i values = _mm256_load_si256(reinterpret_cast<const __m256i*>(rows[d] + i));
+				if (rowsAtLeastLimits)
+					fail = _mm256_or_si256(fail, _mm256_cmpgt_epi32(limit, values));
+				else
+					fail = _mm256_or_si256(fail, _mm256_cmpgt_epi32(values, limit));
+			}
+			unsigned failBits = _mm256_movemask_ps(_mm256_castsi256_ps(fail));
+			storeByte(result, i, ~failBits & 0xFF);
+		}
+	}
+#endif
+
+	// clears the bits of the padding after the last element
+	void clearPadding(uint64_t* result, int length)
+	{
+		if (length % 64 != 0)
+			result[length / 64] &= (uint64_t(1) << (length % 64)) - 1;
+	}
+}
+
+ResourceMatrix::ResourceMatrix(const std::vector<VM>& VMs, const std::vector<PM>& PMs, int dimension)
+	:m_dimension(dimension), m_numVMs((int)VMs.size()), m_numPMs((int)PMs.size())
+{
+	m_VMStride = roundUp(m_numVMs);
+	m_PMStride = roundUp(m_numPMs);
+
+	// the padding never fits: PMs have negative free resources, VMs have maximal demand
+	m_freeStorage.assign((size_t)m_dimension * m_PMStride + ALIGNMENT / sizeof(int), -1);
+	m_demandStorage.assign((size_t)m_dimension * m_VMStride + ALIGNMENT / sizeof(int), INT_MAX);
+	m_freeOffset = alignedOffset(m_freeStorage);
+	m_demandOffset = alignedOffset(m_demandStorage);
+	m_rows.resize(m_dimension);
+	m_limits.resize(m_dimension);
+
+	for (int d = 0; d < m_dimension; d++)
+	{
+		for (int pm = 0; pm < m_numPMs; pm++)
+			freeRow(d)[pm] = PMs[pm].resourcesFree[d];
+		for (int vm = 0; vm < m_numVMs; vm++)
+			demandRow(d)[vm] = VMs[vm].demand[d];
+	}
+
+	m_kernel = SCALAR;
+#ifdef RESOURCEMATRIX_X86_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		m_kernel = AVX2;
+	else if (__builtin_cpu_supports("sse2"))
+		m_kernel = SSE2;
+#endif
+
+	switch (m_dimension)
+	{
+	case 1: m_kernelFunction = selectKernel<1>(m_kernel); break;
+	case 2: m_kernelFunction = selectKernel<2>(m_kernel); break;
+	case 3: m_kernelFunction = selectKernel<3>(m_kernel); break;
+	case 4: m_kernelFunction = selectKernel<4>(m_kernel); break;
+	case 5: m_kernelFunction = selectKernel<5>(m_kernel); break;
+	case 6: m_kernelFunction = selectKernel<6>(m_kernel); break;
+	case 7: m_kernelFunction = selectKernel<7>(m_kernel); break;
+	case 8: m_kernelFunction = selectKernel<8>(m_kernel); break;
+	default: m_kernelFunction = selectKernel<0>(m_kernel); break; // generic version
+	}
+}
+
+// returns the kernel of the given type specialized for dimension D
+template<int D>
+ResourceMatrix::KernelFunction ResourceMatrix::selectKernel(KernelType type)
+{
+	switch (type)
+	{
+#ifdef RESOURCEMATRIX_X86_KERNELS
+	case AVX2:
+		return avx2Kernel<D>;
+	case SSE2:
+		return sse2Kernel<D>;
+#endif
+	default:
+		return scalarKernel<D>;
+	}
+}
+
+// runs the selected kernel, rows and limits are taken from m_rows and m_limits
+void ResourceMatrix::runKernel(int length, int paddedLength, bool rowsAtLeastLimits, uint64_t* result)
+{
+	m_kernelFunction(m_rows.data(), m_limits.data(), m_dimension, paddedLength, rowsAtLeastLimits, result);
+	clearPadding(result, length);
+}
+
+void ResourceMatrix::fittingPMs(int vm, uint64_t* result)
+{
+	for (int d = 0; d < m_dimension; d++)
+	{
+		m_rows[d] = freeRow(d);
+		m_limits[d] = demandRow(d)[vm];
+	}
+	runKernel(m_numPMs, m_PMStride, true, result);
+}
+
+void ResourceMatrix::fittingVMs(int pm, uint64_t* result)
+{
+	for (int d = 0; d < m_dimension; d++)
+	{
+		m_rows[d] = demandRow(d);
+		m_limits[d] = freeRow(d)[pm];
+	}
+	runKernel(m_numVMs, m_VMStride, false, result);
+}
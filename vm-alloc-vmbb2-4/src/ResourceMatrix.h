@@ -0,0 +1,110 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RESOURCEMATRIX_H
+#define RESOURCEMATRIX_H
+
+#include <vector>
+#include <cstdint>
+
+#include "VM.h"
+#include "PM.h"
+
+// number of resource dimensions: D if it is known at compile time, the runtime value if D is 0
+// the code is specialized for D = 1..8, with constant D the loops over dimensions are unrolled
+template<int D>
+inline int dimensionOf(int dimension)
+{
+	return D > 0 ? D : dimension;
+}
+
+// free resources of the PMs and demands of the VMs in struct-of-arrays layout:
+// one row per dimension, every row padded to a multiple of 8 elements and aligned to 32 bytes
+// so that the fit checks can test 8 PMs (or VMs) at once
+class ResourceMatrix
+{
+public:
+	enum KernelType
+	{
+		SCALAR,
+		SSE2,
+		AVX2
+	};
+
+private:
+	int m_dimension;
+	int m_numVMs;
+	int m_numPMs;
+	int m_VMStride; // padded row length for VMs
+	int m_PMStride; // padded row length for PMs
+	KernelType m_kernel;
+
+	using KernelFunction = void(*)(const int* const* rows, const int* limits, int dimension, int paddedLength, bool rowsAtLeastLimits, uint64_t* result);
+	KernelFunction m_kernelFunction; // kernel of the chosen type, specialized for the dimension
+
+	// rows are stored with an offset from the start of the vectors, so that they are aligned
+	std::vector<int> m_freeStorage;
+	std::vector<int> m_demandStorage;
+	size_t m_freeOffset;
+	size_t m_demandOffset;
+
+	// arguments of the kernels, allocated once
+	std::vector<const int*> m_rows;
+	std::vector<int> m_limits;
+
+	int* freeRow(int d) { return m_freeStorage.data() + m_freeOffset + (size_t)d * m_PMStride; }
+	int* demandRow(int d) { return m_demandStorage.data() + m_demandOffset + (size_t)d * m_VMStride; }
+	template<int D> static KernelFunction selectKernel(KernelType type);
+	void runKernel(int length, int paddedLength, bool rowsAtLeastLimits, uint64_t* result);
+
+public:
+	ResourceMatrix() :m_dimension(0), m_numVMs(0), m_numPMs(0), m_VMStride(0), m_PMStride(0), m_kernel(SCALAR), m_kernelFunction(nullptr), m_freeOffset(0), m_demandOffset(0) {}
+	ResourceMatrix(const std::vector<VM>& VMs, const std::vector<PM>& PMs, int dimension);
+
+	// rows are found by offsets that depend on the address of the storage, so copies are not allowed
+	ResourceMatrix(const ResourceMatrix&) = delete;
+	ResourceMatrix& operator=(const ResourceMatrix&) = delete;
+	ResourceMatrix(ResourceMatrix&&) = default;
+	ResourceMatrix& operator=(ResourceMatrix&&) = default;
+
+	KernelType getKernelType() const { return m_kernel; }
+
+	// keeping the free resources in sync with the allocations
+	template<int D>
+	void allocate(int vm, int pm)
+	{
+		for (int d = 0; d < dimensionOf<D>(m_dimension); d++)
+			freeRow(d)[pm] -= demandRow(d)[vm];
+	}
+
+	template<int D>
+	void deAllocate(int vm, int pm)
+	{
+		for (int d = 0; d < dimensionOf<D>(m_dimension); d++)
+			freeRow(d)[pm] += demandRow(d)[vm];
+	}
+
+	// sets the bits of the PMs the VM fits in, result must have room for numPMs bits
+	void fittingPMs(int vm, uint64_t* result);
+
+	// sets the bits of the VMs fitting in the PM, result must have room for numVMs bits
+	void fittingVMs(int pm, uint64_t* result);
+};
+
+#endif
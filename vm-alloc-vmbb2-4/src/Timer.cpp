@@ -21,11 +21,17 @@ along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
 
 void Timer::start()
 {
-	m_beginTime = std::clock();
+	m_beginTime = std::chrono::steady_clock::now();
+	m_beginCPUTime = std::clock();
 }
 
 double Timer::getElapsedTime()
 {
-	double elapsed = double(clock() - m_beginTime) / CLOCKS_PER_SEC;
-	return elapsed;
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_beginTime;
+	return elapsed.count();
+}
+
+double Timer::getElapsedCPUTime()
+{
+	return (double)(std::clock() - m_beginCPUTime) / CLOCKS_PER_SEC;
 }
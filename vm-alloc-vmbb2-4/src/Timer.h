@@ -20,14 +20,18 @@ along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
 #ifndef TIMER_H
 #define TIMER_H
 
+#include <chrono>
 #include <ctime>
 
+// measures wall-clock time (CPU time would add up the time of all worker threads)
 class Timer
 {
-	clock_t m_beginTime;
+	std::chrono::steady_clock::time_point m_beginTime;
+	std::clock_t m_beginCPUTime;
 public:
 	void start();
 	double getElapsedTime();
+	double getElapsedCPUTime(); // CPU time of the process, i.e. of all threads
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,112 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include "Trace.h"
+
+TraceBuffer::TraceBuffer(uint16_t thread, std::chrono::steady_clock::time_point start)
+	:m_events(TRACE_BUFFER_SIZE), m_mask(TRACE_BUFFER_SIZE - 1), m_thread(thread), m_start(start), m_numDropped(0), m_head(0), m_tail(0)
+{
+	static_assert((TRACE_BUFFER_SIZE & (TRACE_BUFFER_SIZE - 1)) == 0, "the size of the trace buffer has to be a power of 2");
+}
+
+// writes the events recorded since the last call to the file, returns their number
+// only called by one thread at a time (the flusher)
+size_t TraceBuffer::drain(std::ofstream& file)
+{
+	uint64_t tail = m_tail.load(std::memory_order_relaxed);
+	uint64_t head = m_head.load(std::memory_order_acquire);
+	size_t count = (size_t)(head - tail);
+
+	while (tail != head)
+	{
+		// the events up to the end of the array, then the ones from its beginning
+		size_t first = (size_t)(tail & m_mask);
+		size_t length = std::min((size_t)(head - tail), m_events.size() - first);
+		file.write(reinterpret_cast<const char*>(&m_events[first]), length * sizeof(TraceEvent));
+		tail += length;
+	}
+
+	m_tail.store(tail, std::memory_order_release);
+	return count;
+}
+
+Tracer::Tracer(const std::string& path)
+	:m_file(path, std::ios::binary | std::ios::app), m_start(std::chrono::steady_clock::now()), m_numWritten(0), m_stopping(false)
+{
+	if (m_file.is_open())
+		m_flusher = std::thread(&Tracer::flushLoop, this);
+}
+
+Tracer::~Tracer()
+{
+	stop();
+}
+
+TraceBuffer* Tracer::addThread()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_buffers.push_back(std::unique_ptr<TraceBuffer>(new TraceBuffer((uint16_t)m_buffers.size(), m_start)));
+	return m_buffers.back().get();
+}
+
+// stops the flusher thread and writes the remaining events, the buffers must not be written anymore
+void Tracer::stop()
+{
+	if (!m_flusher.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_stop.notify_one();
+	m_flusher.join();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	flush();
+	m_file.flush();
+}
+
+uint64_t Tracer::getNumDropped()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	uint64_t dropped = 0;
+	for (auto& buffer : m_buffers)
+		dropped += buffer->getNumDropped();
+	return dropped;
+}
+
+void Tracer::flushLoop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (!m_stopping)
+	{
+		m_stop.wait_for(lock, std::chrono::milliseconds(TRACE_FLUSH_PERIOD_MS));
+		flush();
+	}
+}
+
+// empties every buffer into the file, the mutex has to be held
+void Tracer::flush()
+{
+	for (auto& buffer : m_buffers)
+		m_numWritten += buffer->drain(m_file);
+}
@@ -0,0 +1,138 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+#define TRACE_BUFFER_SIZE (1 << 16) // events in the ring buffer of a search thread (power of 2), 2 MB
+#define TRACE_FLUSH_PERIOD_MS 10 // milliseconds between two runs of the flusher thread
+
+enum TraceEventType : uint8_t
+{
+	TRACE_START, // start of a search (VM: number of VMs, PM: number of PMs), the events after it belong to this session
+	TRACE_ALLOCATE, // VM allocated to PM
+	TRACE_DEALLOCATE, // VM deallocated from PM
+	TRACE_BOUND_CUT, // the allocation of VM to PM is cut, value: lower bound of the cost
+	TRACE_MIGRATION_CUT, // the allocation of VM to PM is cut, value: migrations needed
+	TRACE_INCUMBENT, // better solution found, value: its cost
+	TRACE_BACKTRACK, // the search returns to VM (the last allocated one)
+	NUM_TRACE_EVENT_TYPES
+};
+
+inline const char* traceEventName(int type)
+{
+	static const char* names[] = { "start", "allocate", "deallocate", "bound cut", "migration cut", "incumbent", "backtrack" };
+	return (type >= 0 && type < NUM_TRACE_EVENT_TYPES) ? names[type] : "unknown";
+}
+
+// one event of the search, the trace file is a sequence of these records (in the byte order of the machine)
+struct TraceEvent
+{
+	uint64_t time; // nanoseconds since the start of the search
+	int32_t VMid; // -1 if not applicable
+	int32_t PMid; // -1 if not applicable
+	int32_t depth; // number of allocated VMs
+	uint16_t thread; // 0 for the main search thread, 1.. for the workers of a parallel search
+	uint8_t type; // TraceEventType
+	uint8_t reserved;
+	double value;
+};
+static_assert(sizeof(TraceEvent) == 32, "the trace file format depends on the size of the events");
+
+// lock-free ring buffer of the events of one search thread, the flusher thread takes them out
+// the search never waits: if the buffer is full, the event is dropped (and counted)
+class TraceBuffer
+{
+	std::vector<TraceEvent> m_events;
+	uint64_t m_mask;
+	uint16_t m_thread;
+	std::chrono::steady_clock::time_point m_start;
+	uint64_t m_numDropped; // only written by the search thread
+	char m_padding1[64];
+	std::atomic<uint64_t> m_head; // number of events written, only written by the search thread
+	char m_padding2[64];
+	std::atomic<uint64_t> m_tail; // number of events taken out, only written by the flusher thread
+	char m_padding3[64];
+
+public:
+	TraceBuffer(uint16_t thread, std::chrono::steady_clock::time_point start);
+
+	void record(TraceEventType type, int VMid, int PMid, int depth, double value)
+	{
+		uint64_t head = m_head.load(std::memory_order_relaxed);
+		if (head - m_tail.load(std::memory_order_acquire) == m_events.size())
+		{
+			++m_numDropped;
+			return;
+		}
+		TraceEvent& e = m_events[head & m_mask];
+		e.time = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+		e.VMid = VMid;
+		e.PMid = PMid;
+		e.depth = depth;
+		e.thread = m_thread;
+		e.type = type;
+		e.reserved = 0;
+		e.value = value;
+		m_head.store(head + 1, std::memory_order_release);
+	}
+
+	size_t drain(std::ofstream& file);
+	uint64_t getNumDropped() { return m_numDropped; }
+};
+
+// writes the events of the search threads to a binary trace file (appended), the buffers are emptied periodically by a flusher thread
+class Tracer
+{
+	std::ofstream m_file;
+	std::chrono::steady_clock::time_point m_start;
+	std::vector<std::unique_ptr<TraceBuffer>> m_buffers;
+	uint64_t m_numWritten;
+
+	std::thread m_flusher;
+	bool m_stopping;
+	std::mutex m_mutex; // guards m_buffers and m_stopping
+	std::condition_variable m_stop;
+
+	void flushLoop();
+	void flush();
+
+public:
+	Tracer(const std::string& path);
+	~Tracer(); // stops the flusher thread and writes the remaining events
+
+	bool isOpen() { return m_file.is_open(); }
+	TraceBuffer* addThread(); // the buffer of a new search thread, valid until the tracer is destroyed
+	uint64_t getNumWritten() { return m_numWritten; } // only valid after the tracer is stopped
+	uint64_t getNumDropped();
+	void stop();
+};
+
+#endif
\ No newline at end of file
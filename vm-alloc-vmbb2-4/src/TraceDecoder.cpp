@@ -0,0 +1,160 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Decoder of the trace files written by BnBAllocator (traceFile parameter).
+Usage: tracedecoder.exe <trace file> [text|chrome|summary]
+  text:    one line per event: search, time (ms), thread, depth, type and data of the event (default)
+  chrome:  JSON for chrome://tracing or Perfetto, one process per search, one thread per search thread,
+           allocations are nested slices, the other events are instants, the incumbents are a counter
+  summary: number of events of each type per search
+*/
+
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Trace.h"
+
+using std::cout;
+using std::endl;
+
+static void printText(const TraceEvent& e, int session)
+{
+	printf("%d %14.6f T%-3d d%-5d %-13s", session, e.time / 1e6, e.thread, e.depth, traceEventName(e.type));
+	switch (e.type)
+	{
+	case TRACE_START:
+		printf(" VMs %d PMs %d", e.VMid, e.PMid);
+		break;
+	case TRACE_ALLOCATE:
+	case TRACE_DEALLOCATE:
+		printf(" VM %d PM %d", e.VMid, e.PMid);
+		break;
+	case TRACE_BOUND_CUT:
+		printf(" VM %d PM %d bound %g", e.VMid, e.PMid, e.value);
+		break;
+	case TRACE_MIGRATION_CUT:
+		printf(" VM %d PM %d migrations %g", e.VMid, e.PMid, e.value);
+		break;
+	case TRACE_INCUMBENT:
+		printf(" cost %g", e.value);
+		break;
+	case TRACE_BACKTRACK:
+		printf(" VM %d", e.VMid);
+		break;
+	}
+	printf("\n");
+}
+
+static void printChrome(const TraceEvent& e, int session, bool& first)
+{
+	printf(first ? "\n" : ",\n");
+	first = false;
+
+	double ts = e.time / 1e3; // microseconds
+	switch (e.type)
+	{
+	case TRACE_START:
+		printf("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"search %d (%d VMs, %d PMs)\"}}", session, session, e.VMid, e.PMid);
+		break;
+	case TRACE_ALLOCATE:
+		printf("{\"name\":\"VM %d on PM %d\",\"cat\":\"allocate\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{\"depth\":%d}}", e.VMid, e.PMid, ts, session, e.thread, e.depth);
+		break;
+	case TRACE_DEALLOCATE:
+		printf("{\"ph\":\"E\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}", ts, session, e.thread);
+		break;
+	case TRACE_INCUMBENT:
+		printf("{\"name\":\"best cost\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{\"cost\":%g}},\n", ts, session, e.thread, e.value);
+		// also shown as an instant on the thread that found it
+		// fall through
+	default:
+		printf("{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{\"VM\":%d,\"PM\":%d,\"depth\":%d,\"value\":%g}}",
+			traceEventName(e.type), ts, session, e.thread, e.VMid, e.PMid, e.depth, e.value);
+		break;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		cout << "Usage: " << argv[0] << " <trace file> [text|chrome|summary]" << endl;
+		return 1;
+	}
+	std::string format = (argc > 2) ? argv[2] : "text";
+	if (format != "text" && format != "chrome" && format != "summary")
+	{
+		cout << "Invalid format: " << format << endl;
+		return 1;
+	}
+
+	std::ifstream file(argv[1], std::ios::binary);
+	if (!file.is_open())
+	{
+		cout << "Cannot open trace file " << argv[1] << endl;
+		return 1;
+	}
+
+	int session = -1; // index of the search, counted by the start events
+	bool first = true;
+	std::vector<std::vector<long long>> counts; // for each session and event type
+
+	if (format == "chrome")
+		printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+	TraceEvent e;
+	while (file.read(reinterpret_cast<char*>(&e), sizeof(e)))
+	{
+		if (e.type == TRACE_START || session == -1)
+		{
+			session++;
+			counts.push_back(std::vector<long long>(NUM_TRACE_EVENT_TYPES, 0));
+		}
+		if (e.type < NUM_TRACE_EVENT_TYPES)
+			counts[session][e.type]++;
+
+		if (format == "text")
+			printText(e, session);
+		else if (format == "chrome")
+			printChrome(e, session, first);
+	}
+
+	if (format == "chrome")
+		printf("\n]}\n");
+
+	if (format == "summary")
+	{
+		for (size_t s = 0; s < counts.size(); s++)
+		{
+			cout << "search " << s << ":";
+			for (int type = 0; type < NUM_TRACE_EVENT_TYPES; type++)
+				cout << " " << traceEventName(type) << " " << counts[s][type] << (type + 1 < NUM_TRACE_EVENT_TYPES ? "," : "");
+			cout << endl;
+		}
+	}
+
+	if (file.gcount() != 0)
+	{
+		std::cerr << "Warning: the trace file ends with an incomplete event." << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,71 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRAIL_H
+#define TRAIL_H
+
+#include <vector>
+#include <cstddef>
+#include <cassert>
+
+// undo log of the search: the entries recorded since the last checkpoint are undone on backtracking
+// the buffer is preallocated and never shrinks, so recording and restoring does not allocate memory
+class Trail
+{
+	std::vector<int> m_entries; // recorded entries, oldest first
+	std::vector<size_t> m_checkpoints; // number of entries at each checkpoint
+
+public:
+	void reserve(size_t numEntries, size_t numCheckpoints)
+	{
+		m_entries.reserve(numEntries);
+		m_checkpoints.reserve(numCheckpoints);
+	}
+
+	// starts a new level, the following entries belong to it
+	void checkpoint()
+	{
+		m_checkpoints.push_back(m_entries.size());
+	}
+
+	void record(int entry)
+	{
+		assert(!m_checkpoints.empty());
+		m_entries.push_back(entry);
+	}
+
+	// calls undo for every entry of the last level (newest first), then removes the level
+	template<typename Undo>
+	void restore(Undo undo)
+	{
+		assert(!m_checkpoints.empty());
+		size_t mark = m_checkpoints.back();
+		m_checkpoints.pop_back();
+		while (m_entries.size() > mark)
+		{
+			undo(m_entries.back());
+			m_entries.pop_back();
+		}
+	}
+
+	size_t numLevels() const { return m_checkpoints.size(); }
+	size_t size() const { return m_entries.size(); }
+};
+
+#endif
@@ -23,6 +23,7 @@ along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
 #include <vector>
 
 #include "PM.h"
+#include "Bitset.h"
 
 struct VM
 {
@@ -30,8 +31,10 @@ struct VM
 	std::vector<int> demand;
 	int initialID; // ID of initially assigned PM
 	PM* initialPM;
-	std::vector<PM*>::iterator PMIterator; // "index" in the availablePMs array
-	std::vector<PM*> availablePMs;
+	Bitset availablePMs; // IDs of the PMs the VM still fits in (domain of the VM)
+	std::vector<PM*> candidates; // available PMs in the order they are tried, built when the VM is chosen for branching
+	std::vector<PM*>::iterator PMIterator; // "index" in the candidates array
+	std::vector<int> numEquivalentPMs; // number of PMs in the class of each candidate (1 without symmetry breaking)
 };
 
 bool VMComparator(const VM& first, const VM& second);
@@ -0,0 +1,39 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "VMAllocator.h"
+
+// sends the new best allocation (PM ID for each VM ID) to the subscriber, only the VMs that moved since the previous one are listed
+void VMAllocator::reportIncumbent(double cost, int activeHosts, int migrations, double elapsedTime, const std::vector<int>& PMIdOfVM)
+{
+	if (!m_incumbentCallback)
+		return;
+
+	Incumbent incumbent = { cost, activeHosts, migrations, elapsedTime, {} };
+	m_lastIncumbent.resize(PMIdOfVM.size(), -1);
+	for (size_t vm = 0; vm < PMIdOfVM.size(); vm++)
+	{
+		if (PMIdOfVM[vm] != m_lastIncumbent[vm])
+		{
+			incumbent.changes.push_back(std::make_pair((int)vm, PMIdOfVM[vm]));
+			m_lastIncumbent[vm] = PMIdOfVM[vm];
+		}
+	}
+	m_incumbentCallback(incumbent);
+}
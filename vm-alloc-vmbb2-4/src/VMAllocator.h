@@ -23,14 +23,46 @@ along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
 #include <functional>
 #include <unordered_map>
 #include <stdexcept>
+#include <atomic>
+#include <future>
+#include <vector>
+#include <utility>
 
 #include "AllocationProblem.h"
+#include "PhaseProfiler.h"
 
 #define COEFF_NR_OF_ACTIVE_HOSTS 10
 #define COEFF_NR_OF_MIGRATIONS 1
 
 using AllocationMapType = std::unordered_map <VM*, PM*>;
 
+// a new best allocation found during the search
+struct Incumbent
+{
+	double cost;
+	int activeHosts;
+	int migrations;
+	double elapsedTime; // seconds since the start of solve()
+	std::vector<std::pair<int, int>> changes; // (VM ID, PM ID) of the VMs moved since the previous incumbent, every VM in the first one
+};
+
+using IncumbentCallback = std::function<void(const Incumbent&)>;
+
+// counters of a run of solve(), each allocator fills the ones that make sense for it (the others stay 0, the times -1)
+struct SearchStats
+{
+	long long nodes = 0; // allocations tried by the search
+	long long boundCuts = 0; // allocations cut because the lower bound of the cost is not better than the best so far
+	long long migrationCuts = 0; // allocations cut because they exceed the number of migrations allowed
+	long long symmetrySkips = 0; // candidate PMs not tried because they are interchangeable with an other candidate
+	long long backtracks = 0; // allocations taken back from the stack of allocated VMs
+	int maxDepth = 0; // most VMs allocated at the same time
+	double nodesPerSecond = 0;
+	double timeToFirstIncumbent = -1; // seconds since the start of solve() (or since construction, for an initial solution), -1 if none was found
+	double timeToBestIncumbent = -1;
+	std::vector<PhaseProfile> phases; // indexed by ProfilePhase, only filled when profiling
+};
+
 class VMAllocator
 {
 public:
@@ -54,6 +86,52 @@ public:
 
 	// return lower bound
 	virtual double getLowerBound()=0;
+
+	// solve() returns with the best allocation found so far soon after the token becomes true (set by an other thread or a signal handler)
+	void setStopToken(const std::atomic<bool>* token) { m_stopToken = token; }
+
+	// the callback gets every new best allocation during solve(), it is called on the thread of the search (one call at a time)
+	void setIncumbentCallback(IncumbentCallback callback) { m_incumbentCallback = callback; }
+
+	// runs solve() on a new thread, the future gives the best cost when it returns
+	// the allocator must not be used otherwise until then, the incumbent callback and the stop token work as with solve()
+	std::future<double> solveAsync()
+	{
+		return std::async(std::launch::async, [this]() { solve(); return bestCostValue(); });
+	}
+
+	// returns the counters of the last solve()
+	const SearchStats& getStats() const { return m_stats; }
+
+protected:
+	const std::atomic<bool>* m_stopToken = nullptr;
+	IncumbentCallback m_incumbentCallback;
+	std::vector<int> m_lastIncumbent; // PM ID of each VM ID in the last incumbent reported
+	SearchStats m_stats;
+	bool m_initialSolutionPending = false; // an initial solution was installed before solve(), its time stays in the stats
+
+	// the cost returned by getBestCost(), without its logging (safe to call from the thread of solveAsync())
+	virtual double bestCostValue() { return getBestCost(); }
+	bool stopRequested() const { return m_stopToken != nullptr && m_stopToken->load(std::memory_order_relaxed); }
+	bool reportsIncumbents() const { return (bool)m_incumbentCallback; }
+	void reportIncumbent(double cost, int activeHosts, int migrations, double elapsedTime, const std::vector<int>& PMIdOfVM);
+	void recordIncumbentTime(double elapsedTime)
+	{
+		if (m_stats.timeToFirstIncumbent < 0)
+			m_stats.timeToFirstIncumbent = elapsedTime;
+		m_stats.timeToBestIncumbent = elapsedTime;
+	}
+	// drops the counters of the previous solve(), called at its start
+	void resetStats()
+	{
+		SearchStats stats;
+		if (m_initialSolutionPending)
+		{
+			stats.timeToFirstIncumbent = m_stats.timeToFirstIncumbent;
+			stats.timeToBestIncumbent = m_stats.timeToBestIncumbent;
+		}
+		m_stats = stats;
+	}
 };
 
 #endif
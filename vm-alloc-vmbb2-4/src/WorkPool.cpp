@@ -0,0 +1,140 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <climits>
+
+#include "WorkPool.h"
+
+WorkPool::WorkPool(int numWorkers)
+	:m_numWorkers(numWorkers), m_numIdle(0), m_hunger(0), m_stopped(false), m_timedOut(false),
+	m_bestCost(INT_MAX), m_bestNumPMsOn(INT_MAX), m_bestNumMigrations(INT_MAX)
+{
+
+}
+
+// must be called with the mutex locked
+void WorkPool::updateHunger()
+{
+	m_hunger.store(m_numIdle - (int)m_work.size(), std::memory_order_relaxed);
+}
+
+// adds open subtrees to the pool, the vector is emptied
+void WorkPool::addWork(std::vector<Subtree>& subtrees)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto& subtree : subtrees)
+		{
+			m_work.push_back(std::move(subtree));
+		}
+		updateHunger();
+	}
+	subtrees.clear();
+	m_workAvailable.notify_all();
+}
+
+// waits for an open subtree, returns false when the search is over
+// the search is over when every worker is idle and there is no more work, or the search was stopped
+bool WorkPool::getWork(Subtree& subtree)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	++m_numIdle;
+	updateHunger();
+
+	while (m_work.empty() && !m_stopped)
+	{
+		if (m_numIdle == m_numWorkers) // nobody could produce more work
+		{
+			m_stopped = true;
+			m_workAvailable.notify_all();
+			break;
+		}
+		m_workAvailable.wait(lock);
+	}
+
+	if (m_stopped)
+	{
+		return false;
+	}
+
+	subtree = std::move(m_work.front());
+	m_work.pop_front();
+	--m_numIdle;
+	updateHunger();
+	return true;
+}
+
+// stops every worker
+void WorkPool::stop(bool timedOut)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopped = true;
+		m_timedOut = m_timedOut || timedOut;
+	}
+	m_workAvailable.notify_all();
+}
+
+// saves the solution if it is better than the best one found so far
+void WorkPool::offerSolution(double cost, int numPMsOn, int numMigrations, const Subtree& allocation)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (cost < m_bestCost.load(std::memory_order_relaxed))
+	{
+		m_bestAllocation = allocation;
+		m_bestNumPMsOn = numPMsOn;
+		m_bestNumMigrations = numMigrations;
+		m_bestCost.store(cost, std::memory_order_relaxed);
+		if (m_onImprovement)
+			m_onImprovement(cost, numPMsOn, numMigrations, allocation); // under the lock, so the calls are in the order of the costs
+	}
+}
+
+void WorkPool::setImprovementCallback(std::function<void(double, int, int, const Subtree&)> callback)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_onImprovement = callback;
+}
+
+// the following getters are meant to be called after the workers have finished
+
+bool WorkPool::hasSolution()
+{
+	return !m_bestAllocation.empty();
+}
+
+const Subtree& WorkPool::getBestAllocation()
+{
+	return m_bestAllocation;
+}
+
+int WorkPool::getBestNumPMsOn()
+{
+	return m_bestNumPMsOn;
+}
+
+int WorkPool::getBestNumMigrations()
+{
+	return m_bestNumMigrations;
+}
+
+bool WorkPool::timedOut()
+{
+	return m_timedOut;
+}
@@ -0,0 +1,82 @@
+/*
+Copyright 2015 David Bartok, Zoltan Adam Mann
+
+This file is part of VMAllocation.
+
+VMAllocation is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+VMAllocation is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with VMAllocation. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// one branching decision: VM (by ID) allocated to PM (by ID)
+struct Decision
+{
+	int VMid;
+	int PMid;
+};
+
+// a subtree of the search tree, given by the decisions leading from the root to it
+using Subtree = std::vector<Decision>;
+
+// open subtrees and the best solution shared by the worker threads of a parallel search
+class WorkPool
+{
+	int m_numWorkers;
+	int m_numIdle; // workers waiting for a subtree
+	std::deque<Subtree> m_work; // open subtrees, shallowest first
+	std::atomic<int> m_hunger; // idle workers not yet served by a queued subtree
+	std::atomic<bool> m_stopped; // search finished, timed out or stopped otherwise
+	bool m_timedOut;
+
+	std::atomic<double> m_bestCost; // cost of the best solution found by any worker
+	Subtree m_bestAllocation; // best solution found by any worker (every VM is decided)
+	int m_bestNumPMsOn;
+	int m_bestNumMigrations;
+	std::function<void(double, int, int, const Subtree&)> m_onImprovement; // called with every better solution (cost, PMs on, migrations, allocation)
+
+	std::mutex m_mutex;
+	std::condition_variable m_workAvailable;
+
+	void updateHunger();
+
+public:
+	WorkPool(int numWorkers);
+
+	void addWork(std::vector<Subtree>& subtrees);
+	bool getWork(Subtree& subtree);
+	void stop(bool timedOut);
+
+	// cheap checks, called at every node of the search
+	bool hasIdleWorkers() { return m_hunger.load(std::memory_order_relaxed) > 0; }
+	bool isStopped() { return m_stopped.load(std::memory_order_relaxed); }
+	double getBestCost() { return m_bestCost.load(std::memory_order_relaxed); }
+
+	void offerSolution(double cost, int numPMsOn, int numMigrations, const Subtree& allocation);
+	void setImprovementCallback(std::function<void(double, int, int, const Subtree&)> callback);
+	bool hasSolution();
+	const Subtree& getBestAllocation();
+	int getBestNumPMsOn();
+	int getBestNumMigrations();
+	bool timedOut();
+};
+
+#endif
@@ -33,22 +33,41 @@ Result files are created in the .\logs folder.
 #include <fstream>
 #include <climits>
 #include <memory>
+#include <atomic>
+#include <csignal>
 
 #include "BnBAllocator.h"
 #include "IlpAllocator.h"
 #include "AllocationProblem.h"
+#include "PreprocessedProblem.h"
 #include "ProblemGenerator.h"
 #include "Timer.h"
 #include "AllocatorParams.h"
 #include "Utils.h"
 #include "ConfigParser.h"
-//#include "GreedyAllocator.h"
+#include "GreedyAllocator.h"
 
 using std::cout;
 using std::vector;
 using std::ofstream;
 using std::endl;
 
+// set by the first Ctrl+C: the running allocator returns its best solution and no new instance is started
+static std::atomic<bool> interrupted(false);
+
+static void onInterrupt(int)
+{
+	interrupted = true;
+	std::signal(SIGINT, SIG_DFL); // a second Ctrl+C terminates the program
+}
+
+// the phases of the profiled configurations have their own columns in the results
+static bool isProfiled(const std::shared_ptr<AllocatorParams>& params)
+{
+	std::shared_ptr<BnBParams> bnbParams = std::dynamic_pointer_cast<BnBParams>(params);
+	return bnbParams && bnbParams->profile;
+}
+
 int main()
 {
 	std::string timeString = currentDateTime();
@@ -65,6 +84,7 @@ int main()
 	}
 
 	Timer t;
+	std::signal(SIGINT, onInterrupt);
 
 	ConfigParser parser("config.txt");
 	parser.parse();
@@ -83,6 +103,7 @@ int main()
 	output << "; ";
 
 	bool showDetailedCost = parser.getShowDetailedCost();
+	bool showSearchStats = parser.getShowSearchStats();
 	for (unsigned i = 0; i < paramsList.size(); i++) // columns for runtimes
 		output << paramsList[i]->name << ": time; ";
 	for (unsigned i = 0; i < paramsList.size(); i++) // columns for other data
@@ -94,6 +115,31 @@ int main()
 			output << paramsList[i]->name << ": PMs on; ";
 			output << paramsList[i]->name << ": migrations;";
 		}
+		if (showSearchStats)
+		{
+			output << paramsList[i]->name << ": nodes; ";
+			output << paramsList[i]->name << ": bound cuts; ";
+			output << paramsList[i]->name << ": migration cuts; ";
+			output << paramsList[i]->name << ": symmetry skips; ";
+			output << paramsList[i]->name << ": backtracks; ";
+			output << paramsList[i]->name << ": max depth; ";
+			output << paramsList[i]->name << ": nodes per second; ";
+			output << paramsList[i]->name << ": first incumbent time; ";
+			output << paramsList[i]->name << ": best incumbent time; ";
+		}
+		if (isProfiled(paramsList[i]))
+		{
+			for (int p = 0; p < NUM_PROFILE_PHASES; p++)
+			{
+				output << paramsList[i]->name << ": " << profilePhaseName(p) << " time; ";
+				output << paramsList[i]->name << ": " << profilePhaseName(p) << " worker time; ";
+				for (int c = 0; c < NUM_PROFILE_COUNTERS; c++)
+					output << paramsList[i]->name << ": " << profilePhaseName(p) << " " << profileCounterName(c) << "; ";
+			}
+			output << paramsList[i]->name << ": time per node; ";
+			for (int c = 0; c < NUM_PROFILE_COUNTERS; c++)
+				output << paramsList[i]->name << ": " << profileCounterName(c) << " per node; ";
+		}
 	}
 
 	output << endl;
@@ -102,13 +148,13 @@ int main()
 	ConfigParser::Steps pmSteps = parser.getPMs();
 	int numVMs = vmSteps.from;
 	int numPMs = pmSteps.from;
-	while (numVMs <= vmSteps.to && numPMs <= pmSteps.to)
+	while (numVMs <= vmSteps.to && numPMs <= pmSteps.to && !interrupted)
 	{
 		// run tests
 		cout << "VMs: " << numVMs << " PMs: " << numPMs << ", Running " << parser.getNumTests() << " test(s) with " << paramsList.size() << " parameter setups each..." << endl;
 
 		generator->setNumVMsNumPMs(numVMs, numPMs); // finalizing generator
-		for (int i = 0; i < parser.getNumTests(); i++) // run for all instances
+		for (int i = 0; i < parser.getNumTests() && !interrupted; i++) // run for all instances
 		{
 			cout << "Instance " << i << ":" << endl;
 
@@ -153,10 +199,14 @@ int main()
 				log << std::endl << std::endl;
 			#endif
 
+			// the allocators share the read-only data of the instance, each of them copies only what it modifies
+			std::shared_ptr<const PreprocessedProblem> preprocessed = std::make_shared<const PreprocessedProblem>(problem);
+
 			vector<double> solutions; // costs
 			vector<int> activeHosts;
 			vector<int> migrations;
 			vector<double> lowerBounds;
+			vector<SearchStats> stats;
 
 			output << numVMs << " VMs, " << numPMs << " PMs";
 			output << "; ";
@@ -171,16 +221,17 @@ int main()
 				std::shared_ptr<VMAllocator> vmAllocator;
 				if (paramsList[i]->allocatorType == BnB)
 				{
-					vmAllocator = std::make_shared<BnBAllocator>(problem, paramsList[i], log);
+					vmAllocator = std::make_shared<BnBAllocator>(preprocessed, paramsList[i], log);
 				}
 				else if (paramsList[i]->allocatorType == ILP)
 				{
-					vmAllocator = std::make_shared<ILPAllocator>(problem, paramsList[i], log);
+					vmAllocator = std::make_shared<ILPAllocator>(preprocessed, paramsList[i], log);
 				}
 				else if (paramsList[i]->allocatorType == Greedy)
 				{
-					//vmAllocator = std::make_shared<GreedyAllocator>(problem, paramsList[i], log);
+					vmAllocator = std::make_shared<GreedyAllocator>(preprocessed, paramsList[i], log);
 				}
+				vmAllocator->setStopToken(&interrupted);
 				double loBo=vmAllocator->getLowerBound();
 				lowerBounds.push_back(loBo);
 				t.start();
@@ -196,6 +247,7 @@ int main()
 					activeHosts.push_back(vmAllocator->getActiveHosts());
 					migrations.push_back(vmAllocator->getMigrations());
 				}
+				stats.push_back(vmAllocator->getStats());
 				#ifdef VERBOSE_BASIC			
 					log << "Solution = " << opt << endl;
 					log << "------------------" << endl;
@@ -215,6 +267,35 @@ int main()
 					output << migrations[i];
 					output << "; ";
 				}
+				if (showSearchStats)
+				{
+					output << stats[i].nodes << "; ";
+					output << stats[i].boundCuts << "; ";
+					output << stats[i].migrationCuts << "; ";
+					output << stats[i].symmetrySkips << "; ";
+					output << stats[i].backtracks << "; ";
+					output << stats[i].maxDepth << "; ";
+					output << stats[i].nodesPerSecond << "; ";
+					output << stats[i].timeToFirstIncumbent << "; ";
+					output << stats[i].timeToBestIncumbent << "; ";
+				}
+				if (isProfiled(paramsList[i]))
+				{
+					// counters not available: -1
+					const std::vector<PhaseProfile>& phases = stats[i].phases;
+					for (const PhaseProfile& phase : phases)
+					{
+						output << phase.time << "; ";
+						output << phase.workerTime << "; ";
+						for (int c = 0; c < NUM_PROFILE_COUNTERS; c++)
+							output << phase.counters[c] << "; ";
+					}
+					const PhaseProfile& search = phases[PHASE_SEARCH];
+					long long nodes = stats[i].nodes;
+					output << (nodes > 0 ? search.time / nodes : 0) << "; ";
+					for (int c = 0; c < NUM_PROFILE_COUNTERS; c++)
+						output << (search.counters[c] < 0 ? -1 : nodes > 0 ? (double)search.counters[c] / nodes : 0) << "; ";
+				}
 			}
 
 			output << endl;
@@ -233,5 +314,5 @@ int main()
 
 	output.close();
 	log.close();
-	cout << "(Finished.)" << endl;
+	cout << (interrupted ? "(Interrupted.)" : "(Finished.)") << endl;
 }